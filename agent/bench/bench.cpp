@@ -0,0 +1,99 @@
+/*
+ * bench.cpp
+ *
+ * End to end search benchmark. Each position of the suite in positions.h (the
+ * second and third moves of the game and positions later in it) is searched by
+ * iterDeepSearch on one thread, first to a fixed depth and then to a fixed
+ * number of nodes, from an empty transposition table. For each search the
+ * nodes, nodes per second, depth reached, transposition table hit rate and
+ * chosen move are reported, then the totals.
+ *
+ * Everything but the times is deterministic: the node counts only change if
+ * the search does, so compare the total nodes before and after a change to
+ * GameEngine to catch an unintended one.
+ *
+ * Build and run from agent:
+ *   make bench && bin/bench [depth] [nodes] [pruning]
+ *
+ * With pruning 0 futility pruning is turned off, with pruning 2 late move
+ * reductions are turned on as well, to measure what each saves.
+ *
+ *  Created on: 16/10/2026
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "GameEngine.h"
+#include "positions.h"
+
+namespace {
+
+enum { DEFAULT_DEPTH = 9 };
+const unsigned long DEFAULT_NODES = 500000;
+
+// search every position with the given limits, reporting each and the total
+bool runSuite(const char *name, int depth, unsigned long nodeLimit,
+		int pruning) {
+	using std::cout;
+	using std::endl;
+	using std::setw;
+
+	GameEngine ge;
+	ge.setThreads(1);
+	ge.setHashSize(TTable::DEFAULT_MB);
+	ge.setDepthLimit(depth);
+	ge.setNodeLimit(nodeLimit);
+	ge.setFutility(pruning > 0);
+	ge.setReductions(pruning > 1);
+
+	cout << name << endl;
+	cout << "pos      nodes       nps  depth  tt hits  move" << endl;
+	SearchStats total;
+	double totalMs = 0;
+	for (int i = 0; i != NUM_POSITIONS; ++i) {
+		if (!setPosition(ge, POSITIONS[i])) {
+			cout << "position " << i + 1 << " is not legal" << endl;
+			return false;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		int move = ge.iterDeepSearch(1);
+		std::chrono::duration<double, std::milli> ms =
+				std::chrono::steady_clock::now() - start;
+
+		const SearchStats &stats = ge.getStats();
+		total.add(stats);
+		totalMs += ms.count();
+		cout << setw(3) << i + 1 << setw(11) << stats.nodes
+				<< setw(10) << long(stats.nodes / (ms.count() / 1000 + 1e-9))
+				<< setw(7) << ge.getDepth()
+				<< setw(8) << std::fixed << std::setprecision(1)
+				<< 100 * stats.ttHitRate() << "%"
+				<< setw(6) << move << endl;
+	}
+	cout << "total " << total.nodes << " nodes, "
+			<< long(total.nodes / (totalMs / 1000 + 1e-9)) << " nps, "
+			<< 100 * total.ttHitRate() << "% tt hits" << endl << endl;
+	return true;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+	int depth = argc > 1 ? std::atoi(argv[1]) : DEFAULT_DEPTH;
+	unsigned long nodes = argc > 2 ? std::strtoul(argv[2], nullptr, 0)
+			: DEFAULT_NODES;
+	int pruning = argc > 3 ? std::atoi(argv[3]) : 1;
+
+	std::string byDepth = "depth " + std::to_string(depth);
+	std::string byNodes = std::to_string(nodes) + " nodes";
+	if (!runSuite(byDepth.c_str(), depth, 0, pruning) ||
+			!runSuite(byNodes.c_str(), 0, nodes, pruning)) {
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
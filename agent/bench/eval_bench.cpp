@@ -0,0 +1,144 @@
+/*
+ * eval_bench.cpp
+ *
+ * Microbenchmark for SubBoard::evaluate. Times the table lookup against the
+ * direct calculation it replaced (SubBoard::evaluateDirect) over the same set
+ * of random sub-boards, and checks that both give the same answers. Then does
+ * the same for SubBoard::evaluateMoves, which scores every move on a board at
+ * once, checking the scalar version (nine lookups) and the AVX2 version (if
+ * the processor has AVX2) against evaluate and timing both.
+ *
+ * Build and run from agent:
+ *   make eval_bench && bin/eval_bench
+ *
+ *  Created on: 16/10/2026
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "SubBoard.h"
+
+namespace {
+
+enum { BOARDS = 1 << 16, REPEATS = 200 };
+
+// time fn over every board REPEATS times, returning ns per call
+template <typename F>
+double timeEval(const std::vector<SubBoard> &boards, F fn, long &sum) {
+	auto start = std::chrono::steady_clock::now();
+	for (int r = 0; r != REPEATS; ++r) {
+		for (const SubBoard &b : boards) {
+			sum += fn(b);
+		}
+	}
+	std::chrono::duration<double, std::nano> elapsed =
+			std::chrono::steady_clock::now() - start;
+	return elapsed.count() / (double(REPEATS) * boards.size());
+}
+
+// time fn (an evaluateMoves version) over every board, returning ns per board
+template <typename F>
+double timeMoves(const std::vector<SubBoard> &boards, F fn, long &sum) {
+	int values[9];
+	auto start = std::chrono::steady_clock::now();
+	for (int r = 0; r != REPEATS; ++r) {
+		for (const SubBoard &b : boards) {
+			fn(b.getBoard(), SubBoard::X_MARK, values);
+			sum += values[0] + values[4] + values[8];
+		}
+	}
+	std::chrono::duration<double, std::nano> elapsed =
+			std::chrono::steady_clock::now() - start;
+	return elapsed.count() / (double(REPEATS) * boards.size());
+}
+
+// evaluateMoves the slow way, a board and an evaluate for each position
+void evaluateEach(unsigned long board, int val, int *values) {
+	for (int pos = 1; pos != 10; ++pos) {
+		SubBoard b;
+		for (int p = 1; p != 10; ++p) {
+			if (p != pos) b.update(p, (board >> 2 * (p - 1)) & 3);
+		}
+		b.update(pos, val | ((board >> 2 * (pos - 1)) & 3));
+		values[pos - 1] = b.evaluate();
+	}
+}
+
+}
+
+int main() {
+	using std::cout;
+	using std::endl;
+
+	// random boards as they occur in play: a random number of marks in
+	// random positions, alternating X and O
+	std::default_random_engine generator(3411);
+	std::uniform_int_distribution<int> marks(0, 9), pos(1, 9);
+	std::vector<SubBoard> boards(BOARDS);
+	for (SubBoard &b : boards) {
+		int n = marks(generator);
+		for (int i = 0; i != n; ++i) {
+			int p = pos(generator);
+			if (b.query(p) == SubBoard::BLANK) {
+				b.update(p, i % 2 ? SubBoard::O_MARK : SubBoard::X_MARK);
+			}
+		}
+	}
+
+	for (const SubBoard &b : boards) {
+		if (b.evaluate() != b.evaluateDirect()) {
+			cout << "mismatch on board " << b.getBoard() << endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	long sumDirect = 0, sumTable = 0;
+	double direct = timeEval(boards,
+			[](const SubBoard &b) { return b.evaluateDirect(); }, sumDirect);
+	double table = timeEval(boards,
+			[](const SubBoard &b) { return b.evaluate(); }, sumTable);
+
+	cout << "boards:   " << BOARDS << " x " << REPEATS << endl;
+	cout << "direct:   " << direct << " ns/eval" << endl;
+	cout << "table:    " << table << " ns/eval" << endl;
+	cout << "speedup:  " << direct / table << "x" << endl;
+
+
+	bool avx2 = __builtin_cpu_supports("avx2");
+	for (const SubBoard &b : boards) {
+		int each[9], scalar[9], vector[9];
+		evaluateEach(b.getBoard(), SubBoard::O_MARK, each);
+		SubBoard::evaluateMovesScalar(b.getBoard(), SubBoard::O_MARK, scalar);
+		if (avx2) {
+			SubBoard::evaluateMovesAVX2(b.getBoard(), SubBoard::O_MARK, vector);
+		}
+		for (int i = 0; i != 9; ++i) {
+			if (scalar[i] != each[i] || (avx2 && vector[i] != each[i])) {
+				cout << "evaluateMoves mismatch on board " << b.getBoard()
+						<< endl;
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	long sumScalar = 0, sumVector = 0;
+	double scalar = timeMoves(boards, SubBoard::evaluateMovesScalar, sumScalar);
+	cout << "moves, scalar: " << scalar << " ns/board" << endl;
+	if (avx2) {
+		double vector = timeMoves(boards, SubBoard::evaluateMovesAVX2,
+				sumVector);
+		cout << "moves, avx2:   " << vector << " ns/board" << endl;
+	}
+	else {
+		sumVector = sumScalar;
+		cout << "moves, avx2:   not supported" << endl;
+	}
+
+	// the sums keep the compiler from discarding the work
+	return sumDirect == sumTable && sumScalar == sumVector
+			? EXIT_SUCCESS : EXIT_FAILURE;
+}
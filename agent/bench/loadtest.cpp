@@ -0,0 +1,287 @@
+/*
+ * loadtest.cpp
+ *
+ * Load test for server mode (see Server.h). Opens many connections to an
+ * agent started with -l and acts as the game server on each at once, playing
+ * a series of games on every connection against a random player, refereed by
+ * game.c's make_move. The agent is X in every other game. Reports the agent's
+ * wins, draws, losses and illegal moves, and the time from sending each
+ * request for a move to receiving the reply: mean, 99th percentile and
+ * maximum, which should stay within the agent's move time (-T) however many
+ * games are running.
+ *
+ * Build and run from agent, with the agent already serving:
+ *   make loadtest
+ *   bin/agent -l 31415 -g 200 -m 256 -T 400 &
+ *   bin/loadtest -c 200 -g 2
+ *
+ *  Created on: 16/10/2026
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+extern "C" {
+#include "common.h"
+#include "game.h"
+}
+
+namespace {
+
+typedef std::chrono::steady_clock clock;
+
+enum { MAX_MOVES = 81, FAILED = -1 };
+
+struct Options {
+	const char *host = "localhost";
+	int port = 31415;
+	int connections = 100;
+	int games = 2; // per connection
+	unsigned seed = 1;
+};
+
+// results over all connections
+struct Results {
+	int wins = 0, draws = 0, losses = 0, illegal = 0, failed = 0;
+	std::vector<double> latencies; // ms
+};
+
+// a connection to the agent, with buffered reading of its replies
+class Connection {
+public:
+	explicit Connection(int fd) : fd(fd) { }
+	~Connection() { if (fd >= 0) close(fd); }
+
+	bool send(const std::string &message) {
+		std::string line = message + "\n";
+		return ::send(fd, line.data(), line.size(), MSG_NOSIGNAL)
+				== ssize_t(line.size());
+	}
+
+	// the next move sent by the agent, 0 if the connection closes
+	int readMove() {
+		std::string token;
+		for (;;) {
+			if (next == end) {
+				ssize_t n = recv(fd, buf, sizeof(buf), 0);
+				if (n <= 0) return 0;
+				next = buf;
+				end = buf + n;
+			}
+			char c = *next++;
+			if (c == '\n' || c == ' ') {
+				if (!token.empty()) return std::atoi(token.c_str());
+			}
+			else {
+				token.push_back(c);
+			}
+		}
+	}
+
+private:
+	int fd;
+	char buf[256];
+	char *next = buf;
+	char *end = buf;
+};
+
+int connectTo(const Options &opt) {
+	hostent *h = gethostbyname(opt.host);
+	if (h == nullptr) return -1;
+	sockaddr_in addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sin_family = h->h_addrtype;
+	std::memcpy(&addr.sin_addr.s_addr, h->h_addr_list[0], h->h_length);
+	addr.sin_port = htons(opt.port);
+
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0) return -1;
+	int one = 1;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+std::string message(const char *name, int a, int b = 0, int c = 0, int n = 1) {
+	char buf[64];
+	if (n == 1) std::snprintf(buf, sizeof(buf), "%s(%d).", name, a);
+	else if (n == 2) std::snprintf(buf, sizeof(buf), "%s(%d,%d).", name, a, b);
+	else std::snprintf(buf, sizeof(buf), "%s(%d,%d,%d).", name, a, b, c);
+	return buf;
+}
+
+/* play one game with the agent as X (game.c player 0) or O, the first move
+ * (and, with the agent as X, its reply) chosen at random as the game server
+ * does. Returns game.c's WIN, LOSS or DRAW for the agent, or ILLEGAL_MOVE if
+ * it made one, or FAILED if the connection failed. */
+int playGame(Connection &conn, bool agentX, std::default_random_engine &rng,
+		std::vector<double> &latencies) {
+	std::uniform_int_distribution<int> square(1, 9);
+	int board[10][10];
+	int move[MAX_MOVES + 1];
+	reset_board(board);
+	int agent = agentX ? 0 : 1;
+
+	// a random move onto a blank square of the current sub-board
+	auto randomMove = [&](int m) {
+		int c;
+		do c = square(rng); while (board[move[m - 1]][c] != EMPTY);
+		return c;
+	};
+
+	if (!conn.send(agentX ? "start(x)." : "start(o).")) return FAILED;
+	move[0] = square(rng);
+	move[1] = square(rng);
+	make_move(0, 1, move, board);
+	int m = 2;
+	std::string request = message("second_move", move[0], move[1], 0, 2);
+	if (agentX) {
+		move[2] = randomMove(2);
+		make_move(1, 2, move, board);
+		m = 3;
+		request = message("third_move", move[0], move[1], move[2], 3);
+	}
+
+	for (;;) {
+		// the agent's move
+		clock::time_point sent = clock::now();
+		if (!conn.send(request)) return FAILED;
+		move[m] = conn.readMove();
+		std::chrono::duration<double, std::milli> ms = clock::now() - sent;
+		latencies.push_back(ms.count());
+		if (move[m] < 1 || move[m] > 9) return FAILED;
+
+		int status = make_move(agent, m, move, board);
+		if (status == ILLEGAL_MOVE) {
+			conn.send("loss(illegal_move).");
+			return ILLEGAL_MOVE;
+		}
+		if (status == WIN) {
+			conn.send("win(triple).");
+			return WIN;
+		}
+		if (status == DRAW || m == MAX_MOVES) {
+			conn.send("draw(full_board).");
+			return DRAW;
+		}
+
+		// the random player's reply
+		++m;
+		move[m] = randomMove(m);
+		status = make_move(1 - agent, m, move, board);
+		if (status == WIN || status == DRAW) {
+			conn.send(message("last_move", move[m]));
+			conn.send(status == WIN ? "loss(triple)." : "draw(full_board).");
+			return status == WIN ? LOSS : DRAW;
+		}
+		++m;
+		request = message("next_move", move[m - 1]);
+	}
+}
+
+// a series of games on one connection
+void playSeries(const Options &opt, int id, Results &results,
+		std::mutex &mutex) {
+	Results mine;
+	int fd = connectTo(opt);
+	if (fd < 0) {
+		std::lock_guard<std::mutex> lock(mutex);
+		++results.failed;
+		return;
+	}
+	Connection conn(fd);
+	std::default_random_engine rng(opt.seed * 1000003u + id);
+	conn.send("init.");
+	for (int g = 0; g != opt.games; ++g) {
+		int result = playGame(conn, g % 2 == 0, rng, mine.latencies);
+		if (result == WIN) ++mine.wins;
+		else if (result == DRAW) ++mine.draws;
+		else if (result == LOSS) ++mine.losses;
+		else if (result == ILLEGAL_MOVE) ++mine.illegal;
+		else {
+			++mine.failed;
+			break;
+		}
+	}
+	conn.send("end");
+
+	std::lock_guard<std::mutex> lock(mutex);
+	results.wins += mine.wins;
+	results.draws += mine.draws;
+	results.losses += mine.losses;
+	results.illegal += mine.illegal;
+	results.failed += mine.failed;
+	results.latencies.insert(results.latencies.end(), mine.latencies.begin(),
+			mine.latencies.end());
+}
+
+void usage(const char *argv0) {
+	std::printf("Usage: %s [-h host] [-p port] [-c connections] "
+			"[-g games per connection] [-s seed]\n", argv0);
+	std::exit(EXIT_FAILURE);
+}
+
+}
+
+int main(int argc, char *argv[]) {
+	Options opt;
+	for (int i = 1; i < argc; i += 2) {
+		if (i + 1 >= argc) usage(argv[0]);
+		std::string flag(argv[i]);
+		if (flag == "-h") opt.host = argv[i + 1];
+		else if (flag == "-p") opt.port = std::atoi(argv[i + 1]);
+		else if (flag == "-c") opt.connections = std::atoi(argv[i + 1]);
+		else if (flag == "-g") opt.games = std::atoi(argv[i + 1]);
+		else if (flag == "-s") opt.seed = std::strtoul(argv[i + 1], nullptr, 0);
+		else usage(argv[0]);
+	}
+
+	Results results;
+	std::mutex mutex;
+	clock::time_point start = clock::now();
+	std::vector<std::thread> threads;
+	for (int c = 0; c != opt.connections; ++c) {
+		threads.emplace_back(playSeries, std::cref(opt), c, std::ref(results),
+				std::ref(mutex));
+	}
+	for (std::thread &t : threads) {
+		t.join();
+	}
+	std::chrono::duration<double> secs = clock::now() - start;
+
+	std::vector<double> &lat = results.latencies;
+	std::sort(lat.begin(), lat.end());
+	double mean = 0;
+	for (double l : lat) mean += l;
+	if (!lat.empty()) mean /= lat.size();
+
+	std::printf("%d connections x %d games in %.1f s: W %d D %d L %d, "
+			"illegal %d, failed %d\n", opt.connections, opt.games, secs.count(),
+			results.wins, results.draws, results.losses, results.illegal,
+			results.failed);
+	if (!lat.empty()) {
+		std::printf("%zu moves, %.0f moves/s, latency mean %.1f ms, "
+				"p99 %.1f ms, max %.1f ms\n", lat.size(), lat.size() / secs.count(),
+				mean, lat[lat.size() * 99 / 100], lat.back());
+	}
+	return results.failed == 0 && results.illegal == 0
+			? EXIT_SUCCESS : EXIT_FAILURE;
+}
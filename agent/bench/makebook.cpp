@@ -0,0 +1,125 @@
+/*
+ * makebook.cpp
+ *
+ * Builds the opening book (see Book.h). Every position the agent can be asked
+ * to move from at its second or third move of the game is searched to a fixed
+ * depth, spread over several threads with an engine each, and the moves found
+ * are written to the book. The positions are set up exactly as agent.cpp
+ * sets them up, so their keys match those seen in play.
+ *
+ * The second move follows any of the 81 first moves; the third move follows
+ * our first move (any of 81, chosen by the server) and any reply to it.
+ *
+ * Build and run from agent:
+ *   make makebook && bin/makebook book.bin [depth] [threads]
+ * and then run the agent with -b book.bin
+ *
+ *  Created on: 16/10/2026
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Book.h"
+#include "GameEngine.h"
+
+namespace {
+
+enum { DEFAULT_DEPTH = 12, HASH_MB = 64 };
+
+// an opening: the moves so far, as sub-board and square of each
+struct Opening {
+	int first[2]; // X's move
+	int second[2]; // O's reply, {0, 0} if the engine is to reply
+};
+
+// every position at our second or third move
+std::vector<Opening> openings() {
+	std::vector<Opening> result;
+	for (int board = 1; board <= 9; ++board) {
+		for (int pos = 1; pos <= 9; ++pos) {
+			result.push_back(Opening{{board, pos}, {0, 0}});
+			for (int reply = 1; reply <= 9; ++reply) {
+				if (pos == board && reply == pos) continue;
+				result.push_back(Opening{{board, pos}, {pos, reply}});
+			}
+		}
+	}
+	return result;
+}
+
+/* set up ge at an opening as agent_second_move or agent_third_move would,
+ * returning the key of the position */
+std::uint64_t setOpening(GameEngine &ge, const Opening &o) {
+	ge.reset();
+	if (o.second[0] == 0) {
+		ge.setPlayer(1);
+		ge.update(o.first[0], o.first[1], ge.getOpponent());
+		ge.setCurrSub(o.first[1]);
+	}
+	else {
+		ge.setPlayer(0);
+		ge.update(o.first[0], o.first[1], ge.getPlayer());
+		ge.update(o.second[0], o.second[1], ge.getOpponent());
+		ge.setCurrSub(o.second[1]);
+	}
+	return ge.getKey();
+}
+
+}
+
+int main(int argc, char *argv[]) {
+	using std::cout;
+	using std::endl;
+
+	if (argc < 2) {
+		cout << "Usage: " << argv[0] << " book [depth] [threads]" << endl;
+		return EXIT_FAILURE;
+	}
+	int depth = argc > 2 ? std::atoi(argv[2]) : DEFAULT_DEPTH;
+	int threads = argc > 3 ? std::atoi(argv[3])
+			: std::max(1u, std::thread::hardware_concurrency());
+
+	std::vector<Opening> positions = openings();
+	std::vector<std::pair<std::uint64_t, int> > moves(positions.size());
+	std::atomic<std::size_t> next(0);
+	std::mutex mutex;
+	std::size_t done = 0;
+
+	auto worker = [&]() {
+		GameEngine ge;
+		ge.setHashSize(HASH_MB);
+		ge.setDepthLimit(depth);
+		std::size_t i;
+		while ((i = next++) < positions.size()) {
+			std::uint64_t key = setOpening(ge, positions[i]);
+			moves[i] = std::make_pair(key, ge.iterDeepSearch(1));
+
+			std::lock_guard<std::mutex> lock(mutex);
+			if (++done % 50 == 0) {
+				cout << done << " of " << positions.size() << endl;
+			}
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; ++t) {
+		workers.emplace_back(worker);
+	}
+	for (std::thread &w : workers) {
+		w.join();
+	}
+
+	if (!Book::write(argv[1], moves)) {
+		cout << "could not write " << argv[1] << endl;
+		return EXIT_FAILURE;
+	}
+	cout << moves.size() << " positions to depth " << depth << " written to "
+			<< argv[1] << endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,76 @@
+/*
+ * perft.cpp
+ *
+ * Checks perft (see Perft.h) against known leaf counts, and reports how fast
+ * the tree is walked. The counts were made with game.c's make_move, so they
+ * follow the game's own rules. Run this after any change to the board
+ * representation, move generation or makeMove/unmakeMove: a wrong count
+ * means a bug.
+ *
+ * Build and run from agent:
+ *   make perft && bin/perft [max depth]
+ *
+ *  Created on: 16/10/2026
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "Perft.h"
+#include "positions.h"
+
+namespace {
+
+enum { MAX_DEPTH = 9 };
+
+// an empty board, the first move to be made on sub-board 5
+const int START[POSITION_MOVES] = {5};
+
+struct Position {
+	const char *name;
+	const int *moves; // see positions.h
+	// leaves at depths 1, 2 ..., 0 where not known
+	unsigned long long leaves[MAX_DEPTH];
+};
+
+const Position CHECKED[] = {
+	{"start", START,
+		{9, 80, 704, 6120, 52584, 446168, 3740664, 30936408, 252740304}},
+	{"move 13", POSITIONS[6],
+		{8, 60, 427, 3172, 22359, 160549, 1093887, 7571931, 0}},
+};
+
+}
+
+int main(int argc, char *argv[]) {
+	using std::cout;
+	using std::endl;
+
+	int maxDepth = argc > 1 ? std::atoi(argv[1]) : 8;
+
+	bool ok = true;
+	for (const Position &pos : CHECKED) {
+		State state;
+		if (!setPosition(state, pos.moves)) {
+			cout << pos.name << " is not legal" << endl;
+			return EXIT_FAILURE;
+		}
+		for (int depth = 1; depth <= maxDepth && depth <= MAX_DEPTH &&
+				pos.leaves[depth - 1] != 0; ++depth) {
+			auto start = std::chrono::steady_clock::now();
+			unsigned long long leaves = perft(state, depth);
+			std::chrono::duration<double> secs =
+					std::chrono::steady_clock::now() - start;
+
+			bool right = (leaves == pos.leaves[depth - 1]);
+			ok = ok && right;
+			cout << pos.name << " depth " << depth << ": " << leaves
+					<< (right ? "" : " WRONG") << ", "
+					<< long(leaves / (secs.count() + 1e-9)) << " leaves/s"
+					<< endl;
+		}
+	}
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,74 @@
+/*
+ * positions.h
+ *
+ * The suite of positions searched by the benchmarks (bench, smp_bench) and
+ * walked by perft, and how to set them up. A position is given as the moves
+ * played so far: the first sub-board, then the square of each move in turn,
+ * X first, ending with 0. Each move's square is the next sub-board.
+ *
+ *  Created on: 17/10/2026
+ */
+
+#ifndef POSITIONS_H_
+#define POSITIONS_H_
+
+#include "GameEngine.h"
+#include "State.h"
+
+enum { POSITION_MOVES = 32 };
+
+/* the second and third moves of the game and positions later in it. No
+ * sub-board has been won in any of them. */
+const int POSITIONS[][POSITION_MOVES] = {
+	// second move
+	{5, 5},
+	{1, 5},
+	{3, 9},
+	// third move
+	{1, 5, 5},
+	{5, 1, 9},
+	{7, 3, 2},
+	// later in the game
+	{3, 2, 5, 2, 9, 8, 8, 7, 4, 2, 6, 1, 7},
+	{1, 2, 2, 7, 3, 5, 5, 4, 1, 4, 8, 7, 7, 6, 8, 5, 1, 9, 1},
+	{4, 9, 3, 6, 8, 2, 1, 8, 6, 4, 4, 7, 8, 7, 9, 8, 9, 9, 2, 5, 3, 8, 1, 2,
+		3},
+	{4, 5, 2, 7, 8, 3, 2, 2, 1, 7, 5, 1, 4, 7, 4, 2, 3, 6, 4, 1, 9, 5, 9, 6,
+		5, 4, 6, 3, 8, 7, 1},
+};
+const int NUM_POSITIONS = sizeof(POSITIONS) / sizeof(POSITIONS[0]);
+
+/* set up state at a position, with the player to move. Returns false if a
+ * move is not to a blank square. */
+inline bool setPosition(State &state, const int *moves) {
+	state.clear();
+	state.setCurrSub(moves[0]);
+	state.setCurrPlayer(SubBoard::X_MARK);
+	for (int n = 1; n != POSITION_MOVES && moves[n] != 0; ++n) {
+		if (state.query(state.getCurrSub(), moves[n]) != SubBoard::BLANK) {
+			return false;
+		}
+		state.makeMove(moves[n]);
+	}
+	return true;
+}
+
+/* set up ge at a position, with the engine to move. Returns false if a move
+ * is not to a blank square. */
+inline bool setPosition(GameEngine &ge, const int *moves) {
+	ge.reset();
+	State check;
+	check.setCurrSub(moves[0]);
+	check.setCurrPlayer(SubBoard::X_MARK);
+	for (int n = 1; n != POSITION_MOVES && moves[n] != 0; ++n) {
+		int board = check.getCurrSub();
+		if (check.query(board, moves[n]) != SubBoard::BLANK) return false;
+		ge.update(board, moves[n], check.getCurrPlayer());
+		check.makeMove(moves[n]);
+	}
+	ge.setPlayer(check.getCurrPlayer() == SubBoard::X_MARK ? 0 : 1);
+	ge.setCurrSub(check.getCurrSub());
+	return true;
+}
+
+#endif /* POSITIONS_H_ */
@@ -0,0 +1,160 @@
+/*
+ * protocol_bench.cpp
+ *
+ * Microbenchmark for the message parser (protocol.h). Parses the same stream
+ * of game server messages with proto_next, in place in a ring buffer, and
+ * with the chain of sscanf and strcmp calls client.c used before, checking
+ * that both agree, and reports the time per message of each.
+ *
+ * Build and run from agent:
+ *   make protocol_bench && bin/protocol_bench
+ *
+ *  Created on: 16/10/2026
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "protocol.h"
+
+namespace {
+
+enum { MESSAGES = 1 << 20 };
+
+// the messages of a game, mostly next_move
+std::string randomMessage(std::default_random_engine &rng) {
+	std::uniform_int_distribution<int> square(1, 9), kind(0, 31);
+	char buf[64];
+	switch (kind(rng)) {
+	case 0: return "init.";
+	case 1: return "start(x).";
+	case 2:
+		std::snprintf(buf, sizeof(buf), "second_move(%d,%d).", square(rng),
+				square(rng));
+		return buf;
+	case 3:
+		std::snprintf(buf, sizeof(buf), "third_move(%d,%d,%d).", square(rng),
+				square(rng), square(rng));
+		return buf;
+	case 4:
+		std::snprintf(buf, sizeof(buf), "last_move(%d).", square(rng));
+		return buf;
+	case 5: return "win(triple).";
+	case 6: return "draw(full_board).";
+	default:
+		std::snprintf(buf, sizeof(buf), "next_move(%d).", square(rng));
+		return buf;
+	}
+}
+
+// parse as client.c did, returning the message type and filling in m
+int parseScanf(const char *buf, proto_msg &m) {
+	char ch;
+	if (std::strcmp(buf, "init.") == 0) return PROTO_INIT;
+	if (std::sscanf(buf, "start(%c).", &ch) == 1) {
+		m.player = (ch == 'x') ? 0 : 1;
+		return PROTO_START;
+	}
+	if (std::sscanf(buf, "second_move(%d,%d).", &m.args[0], &m.args[1]) == 2) {
+		return PROTO_SECOND_MOVE;
+	}
+	if (std::sscanf(buf, "third_move(%d,%d,%d).",
+			&m.args[0], &m.args[1], &m.args[2]) == 3) {
+		return PROTO_THIRD_MOVE;
+	}
+	if (std::sscanf(buf, "next_move(%d).", &m.args[0]) == 1) {
+		return PROTO_NEXT_MOVE;
+	}
+	if (std::sscanf(buf, "last_move(%d).", &m.args[0]) == 1) {
+		return PROTO_LAST_MOVE;
+	}
+	if (std::strcmp(buf, "win(") > 0 && std::strcmp(buf, "win)") < 0) {
+		return PROTO_WIN;
+	}
+	if (std::strcmp(buf, "draw(") > 0 && std::strcmp(buf, "draw)") < 0) {
+		return PROTO_DRAW;
+	}
+	return PROTO_UNKNOWN;
+}
+
+// true if two parsed messages are the same, as far as they are filled in
+bool agree(const proto_msg &a, const proto_msg &b) {
+	if (a.type != b.type) return false;
+	int args = 0;
+	switch (a.type) {
+	case PROTO_START: return a.player == b.player;
+	case PROTO_SECOND_MOVE: args = 2; break;
+	case PROTO_THIRD_MOVE: args = 3; break;
+	case PROTO_NEXT_MOVE: case PROTO_LAST_MOVE: args = 1; break;
+	}
+	return std::equal(a.args, a.args + args, b.args);
+}
+
+}
+
+int main() {
+	using std::cout;
+	using std::endl;
+
+	std::default_random_engine rng(9414);
+	std::vector<std::string> messages(MESSAGES);
+	std::string stream;
+	for (std::string &m : messages) {
+		m = randomMessage(rng);
+		stream += m + "\n";
+	}
+
+	// sscanf, one message at a time as fscanf would give them
+	std::vector<proto_msg> expected(MESSAGES);
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i != MESSAGES; ++i) {
+		expected[i].type = parseScanf(messages[i].c_str(), expected[i]);
+	}
+	std::chrono::duration<double, std::nano> scanned =
+			std::chrono::steady_clock::now() - start;
+
+	// proto_next, the stream copied into the ring in chunks as recv would
+	static proto_ring ring;
+	proto_ring_init(&ring);
+	std::size_t fed = 0;
+	int parsed = 0;
+	bool same = true;
+	start = std::chrono::steady_clock::now();
+	while (parsed != MESSAGES) {
+		proto_msg m;
+		int r = proto_next(&ring, &m);
+		if (r < 0) {
+			cout << "proto_next failed at message " << parsed << endl;
+			return EXIT_FAILURE;
+		}
+		if (r == 0) {
+			int len;
+			char *space = proto_ring_space(&ring, &len);
+			len = std::min<std::size_t>(len, stream.size() - fed);
+			std::memcpy(space, stream.data() + fed, len);
+			proto_ring_produced(&ring, len);
+			fed += len;
+			continue;
+		}
+		same = same && agree(m, expected[parsed++]);
+	}
+	std::chrono::duration<double, std::nano> inPlace =
+			std::chrono::steady_clock::now() - start;
+
+	if (!same) {
+		cout << "proto_next and sscanf disagree" << endl;
+		return EXIT_FAILURE;
+	}
+	cout << "messages:   " << MESSAGES << endl;
+	cout << "sscanf:     " << scanned.count() / MESSAGES << " ns/message" << endl;
+	cout << "proto_next: " << inPlace.count() / MESSAGES
+			<< " ns/message (including the copy into the ring)" << endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,352 @@
+/*
+ * selfplay.cpp
+ *
+ * Self-play tournament between two engine configurations, A and B, played
+ * in-process on several threads, each with its own GameEngine for A and for
+ * B, refereed by game.c's make_move. Each game starts from a few random
+ * plies (after the random first sub-board) and each opening is played twice,
+ * with A as X and then as O. An opening that ends the game, or can't be
+ * finished, is drawn again; if none can be found the pair is not played. Moves
+ * are limited by nodes, depth or time (ms) per move; a node or depth limit
+ * makes the games independent of the load on the machine.
+ *
+ * Reports wins, draws and losses for A, an Elo estimate for A over B with a
+ * 95% interval, and the sequential probability ratio test of elo0 against
+ * elo1 (normal approximation). The two games of an opening are not
+ * independent, so the statistics are of pairs: the variance is that of the
+ * score of a pair, from the counts of its five possible totals (0, 1/2 ... 2
+ * points, the pentanomial). The run stops early once the test accepts either
+ * hypothesis.
+ *
+ * Build and run from agent:
+ *   make selfplay
+ *   bin/selfplay -A nodes=20000 -B nodes=40000 -g 1000
+ *
+ *  Created on: 16/10/2026
+ */
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GameEngine.h"
+
+// after the engine, whose names (WIN, LOSS) common.h's macros would replace
+extern "C" {
+#include "common.h"
+#include "game.h"
+}
+
+namespace {
+
+// limits for each move of one side, 0 for none
+struct Config {
+	unsigned long nodes = 20000;
+	int depth = 0;
+	int time = 0; // ms
+	int hash = 4; // MB
+	int solver = GameEngine::DEFAULT_SOLVER_EMPTY; // empty squares, timed only
+	bool lmr = false; // late move reductions
+	bool futility = true; // futility pruning
+};
+
+struct Options {
+	Config a, b;
+	int games = 1000;
+	int threads = std::max(1u, std::thread::hardware_concurrency());
+	int plies = 4; // random moves at the start of each game
+	unsigned seed = 1;
+	double elo0 = 0, elo1 = 5, alpha = 0.05, beta = 0.05;
+};
+
+// results for engine A, by game and by pair of games with the same opening
+struct Score {
+	int wins = 0, draws = 0, losses = 0;
+	int pairs[5] = {0}; // pairs scoring 0, 1/2, 1, 3/2 and 2 points
+
+	int games() const { return wins + draws + losses; }
+	int numPairs() const {
+		return pairs[0] + pairs[1] + pairs[2] + pairs[3] + pairs[4];
+	}
+	double mean() const { return (wins + draws / 2.0) / games(); }
+
+	// variance of the mean score of a pair's two games
+	double variance() const {
+		double s = mean(), v = 0;
+		for (int i = 0; i != 5; ++i) {
+			v += pairs[i] * (i / 4.0 - s) * (i / 4.0 - s);
+		}
+		return v / numPairs();
+	}
+
+	// add a pair, each result 0, 1 or 2 half points
+	void add(int first, int second) {
+		for (int r : {first, second}) {
+			if (r == 2) ++wins;
+			else if (r == 1) ++draws;
+			else ++losses;
+		}
+		++pairs[first + second];
+	}
+};
+
+double eloToScore(double elo) {
+	return 1 / (1 + std::pow(10, -elo / 400));
+}
+
+double scoreToElo(double s) {
+	s = std::min(std::max(s, 1e-6), 1 - 1e-6);
+	return -400 * std::log10(1 / s - 1);
+}
+
+// log likelihood ratio of elo1 against elo0, see Options
+double llr(const Score &score, const Options &opt) {
+	if (score.numPairs() == 0) return 0;
+	double var = score.variance();
+	if (var == 0) return 0;
+	double s0 = eloToScore(opt.elo0), s1 = eloToScore(opt.elo1);
+	return score.numPairs() * (s1 - s0) * (2 * score.mean() - s0 - s1)
+			/ (2 * var);
+}
+
+void usage(const char *argv0) {
+	std::cout << "Usage: " << argv0 << "\n"
+			<< "       [-A engine A options]\n"
+			<< "       [-B engine B options]\n"
+			<< "       [-g games]\n"
+			<< "       [-j threads]\n"
+			<< "       [-r random opening plies]\n"
+			<< "       [-s seed]\n"
+			<< "       [-e elo0,elo1]\n"
+			<< "engine options are a comma separated list of nodes=N, "
+			<< "depth=N, time=MS, hash=MB, solver=EMPTY, lmr=0|1 and "
+			<< "futility=0|1" << std::endl;
+	std::exit(EXIT_FAILURE);
+}
+
+// parse engine options like "nodes=20000,hash=8", false if malformed
+bool parseConfig(const char *arg, Config &c) {
+	std::string s(arg);
+	std::size_t start = 0;
+	while (start < s.size()) {
+		std::size_t end = s.find(',', start);
+		if (end == std::string::npos) end = s.size();
+		std::string item = s.substr(start, end - start);
+		std::size_t eq = item.find('=');
+		if (eq == std::string::npos) return false;
+		std::string name = item.substr(0, eq);
+		long value = std::strtol(item.c_str() + eq + 1, nullptr, 0);
+		if (name == "nodes") c.nodes = value;
+		else if (name == "depth") c.depth = value;
+		else if (name == "time") c.time = value;
+		else if (name == "hash") c.hash = value;
+		else if (name == "solver") c.solver = value;
+		else if (name == "lmr") c.lmr = value != 0;
+		else if (name == "futility") c.futility = value != 0;
+		else return false;
+		start = end + 1;
+	}
+	// a time or depth limit replaces the default node limit
+	if ((c.time != 0 || c.depth != 0) && std::strstr(arg, "nodes=") == nullptr) {
+		c.nodes = 0;
+	}
+	return true;
+}
+
+Options parseArgs(int argc, char *argv[]) {
+	Options opt;
+	for (int i = 1; i < argc; i += 2) {
+		std::string flag(argv[i]);
+		if (i + 1 >= argc) usage(argv[0]);
+		const char *value = argv[i + 1];
+		if (flag == "-A") {
+			if (!parseConfig(value, opt.a)) usage(argv[0]);
+		}
+		else if (flag == "-B") {
+			if (!parseConfig(value, opt.b)) usage(argv[0]);
+		}
+		else if (flag == "-g") opt.games = std::strtol(value, nullptr, 0);
+		else if (flag == "-j") opt.threads = std::strtol(value, nullptr, 0);
+		else if (flag == "-r") opt.plies = std::strtol(value, nullptr, 0);
+		else if (flag == "-s") opt.seed = std::strtoul(value, nullptr, 0);
+		else if (flag == "-e") {
+			if (std::sscanf(value, "%lf,%lf", &opt.elo0, &opt.elo1) != 2) {
+				usage(argv[0]);
+			}
+		}
+		else usage(argv[0]);
+	}
+	opt.threads = std::max(1, opt.threads);
+	opt.plies = std::min(std::max(0, opt.plies), int(State::MAX_MOVES) - 1);
+	return opt;
+}
+
+// set up an engine for a series of games
+void configure(GameEngine &ge, const Config &c) {
+	ge.setHashSize(c.hash);
+	ge.setThreads(1);
+	ge.setNodeLimit(c.nodes);
+	ge.setDepthLimit(c.depth);
+	if (c.time != 0) ge.setMoveTime(c.time);
+	ge.setSolverEmpty(c.solver);
+	ge.setReductions(c.lmr);
+	ge.setFutility(c.futility);
+}
+
+/* fill in opening with a random first sub-board and plies random moves
+ * after it that leave the game undecided, the same for the same seed. An
+ * opening that gets stuck is started again. False if none is found. */
+bool makeOpening(unsigned seed, int plies, int opening[]) {
+	enum { OPENING_TRIES = 100, MOVE_TRIES = 100 };
+
+	std::default_random_engine generator(seed);
+	std::uniform_int_distribution<int> square(1, 9);
+	int board[10][10];
+	for (int t = 0; t != OPENING_TRIES; ++t) {
+		reset_board(board);
+		opening[0] = square(generator);
+		int player = 0;
+		int m;
+		for (m = 1; m <= plies; ++m) {
+			int status, tries = 0;
+			do {
+				opening[m] = square(generator);
+				status = make_move(player, m, opening, board);
+				if (status != STILL_PLAYING && status != ILLEGAL_MOVE) {
+					board[opening[m - 1]][opening[m]] = EMPTY;
+				}
+			} while (status != STILL_PLAYING && ++tries != MOVE_TRIES);
+			if (status != STILL_PLAYING) break;
+			player = 1 - player;
+		}
+		if (m > plies) return true;
+	}
+	return false;
+}
+
+/* play one game between engines x (game.c player 0) and o, after the opening
+ * made by makeOpening. Returns game.c's WIN, LOSS or DRAW for X. */
+int playGame(GameEngine &x, GameEngine &o, const int opening[], int plies) {
+	enum { START_DEPTH = 5 };
+
+	GameEngine *engines[2] = {&x, &o};
+	for (int e = 0; e != 2; ++e) {
+		engines[e]->reset();
+		engines[e]->setPlayer(e);
+	}
+	const int marks[2] = {SubBoard::X_MARK, SubBoard::O_MARK};
+
+	int board[10][10];
+	int move[State::MAX_MOVES + 1];
+	reset_board(board);
+	move[0] = opening[0];
+
+	int player = 0;
+	for (int m = 1; m <= State::MAX_MOVES; ++m) {
+		int status;
+		if (m <= plies) {
+			move[m] = opening[m];
+			status = make_move(player, m, move, board);
+		}
+		else {
+			engines[player]->setCurrSub(move[m - 1]);
+			move[m] = engines[player]->iterDeepSearch(START_DEPTH);
+			if (move[m] < 1 || move[m] > 9) return player == 0 ? LOSS : WIN;
+			status = make_move(player, m, move, board);
+		}
+
+		if (status == ILLEGAL_MOVE) return player == 0 ? LOSS : WIN;
+		if (status == WIN) return player == 0 ? WIN : LOSS;
+		if (status == DRAW) return DRAW;
+
+		// the engine that made the move has it already
+		for (int e = 0; e != 2; ++e) {
+			if (m <= plies || e != player) {
+				engines[e]->update(move[m - 1], move[m], marks[player]);
+			}
+		}
+		player = 1 - player;
+	}
+	return DRAW;
+}
+
+void report(const Score &score, const Options &opt) {
+	if (score.numPairs() == 0) {
+		std::printf("no games played\n");
+		return;
+	}
+	double s = score.mean();
+	double margin = 1.96 * std::sqrt(score.variance() / score.numPairs());
+	std::printf("games %d: W %d D %d L %d, score %.1f%%, "
+			"elo %+.1f [%+.1f, %+.1f], llr %.2f\n",
+			score.games(), score.wins, score.draws, score.losses, 100 * s,
+			scoreToElo(s), scoreToElo(s - margin), scoreToElo(s + margin),
+			llr(score, opt));
+	std::fflush(stdout);
+}
+
+}
+
+int main(int argc, char *argv[]) {
+	Options opt = parseArgs(argc, argv);
+
+	const double lower = std::log(opt.beta / (1 - opt.alpha));
+	const double upper = std::log((1 - opt.beta) / opt.alpha);
+
+	Score score;
+	std::mutex mutex;
+	std::atomic<int> next(0);
+	std::atomic<bool> stop(false);
+
+	/* pairs of games are taken in turn by each thread, each pair playing an
+	 * opening with A as X and then as O */
+	auto worker = [&]() {
+		GameEngine a, b;
+		configure(a, opt.a);
+		configure(b, opt.b);
+		std::vector<int> opening(opt.plies + 1);
+
+		int pair;
+		while (!stop && (pair = next++) < (opt.games + 1) / 2) {
+			if (!makeOpening(opt.seed * 1000003u + pair, opt.plies,
+					opening.data())) {
+				continue;
+			}
+			// half points for A
+			int first = playGame(a, b, opening.data(), opt.plies);
+			int second = playGame(b, a, opening.data(), opt.plies);
+			first = (first == WIN) ? 2 : (first == DRAW) ? 1 : 0;
+			second = (second == LOSS) ? 2 : (second == DRAW) ? 1 : 0;
+
+			std::lock_guard<std::mutex> lock(mutex);
+			score.add(first, second);
+			if (score.games() % 100 == 0) report(score, opt);
+			double l = llr(score, opt);
+			if (l <= lower || l >= upper) stop = true;
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (int i = 0; i != opt.threads; ++i) {
+		threads.emplace_back(worker);
+	}
+	for (std::thread &t : threads) {
+		t.join();
+	}
+
+	report(score, opt);
+	double l = llr(score, opt);
+	std::printf("sprt elo0 %.1f elo1 %.1f alpha %.2f beta %.2f: %s\n",
+			opt.elo0, opt.elo1, opt.alpha, opt.beta,
+			l >= upper ? "H1 accepted (A is stronger)"
+			: l <= lower ? "H0 accepted (A is not stronger)" : "inconclusive");
+	return EXIT_SUCCESS;
+}
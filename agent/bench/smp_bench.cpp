@@ -0,0 +1,57 @@
+/*
+ * smp_bench.cpp
+ *
+ * Time-to-depth benchmark for the Lazy SMP search. Each position of the suite
+ * in positions.h is searched by iterDeepSearch to a fixed depth with 1, 2, 4
+ * ... up to the given number of threads, and the total time and speedup over
+ * one thread are reported, with the share of beta cutoffs made by the first
+ * move searched (a measure of move ordering).
+ *
+ * Build and run from agent:
+ *   make smp_bench && bin/smp_bench [max threads] [depth]
+ *
+ *  Created on: 16/10/2026
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+#include "GameEngine.h"
+#include "positions.h"
+
+int main(int argc, char *argv[]) {
+	using std::cout;
+	using std::endl;
+
+	int maxThreads = argc > 1 ? std::atoi(argv[1])
+			: std::max(1u, std::thread::hardware_concurrency());
+	int depth = argc > 2 ? std::atoi(argv[2]) : 9;
+
+	cout << "depth " << depth << ", " << NUM_POSITIONS << " positions" << endl;
+	double base = 0;
+	for (int threads = 1; threads <= maxThreads; threads *= 2) {
+		GameEngine ge;
+		ge.setThreads(threads);
+		ge.setDepthLimit(depth);
+
+		SearchStats stats;
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i != NUM_POSITIONS; ++i) {
+			setPosition(ge, POSITIONS[i]);
+			ge.iterDeepSearch(depth);
+			stats.add(ge.getStats());
+		}
+		std::chrono::duration<double, std::milli> ms =
+				std::chrono::steady_clock::now() - start;
+
+		if (threads == 1) base = ms.count();
+		cout << "threads " << threads << ": " << ms.count() << " ms, "
+				<< stats.nodes << " nodes, speedup " << base / ms.count() << "x, "
+				<< 100 * stats.firstCutoffRate() << "% cutoffs on first move"
+				<< endl;
+	}
+
+	return EXIT_SUCCESS;
+}
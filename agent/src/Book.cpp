@@ -0,0 +1,93 @@
+/*
+ * Book.cpp
+ *
+ *  Created on: 16/10/2026
+ */
+
+#include "Book.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const char Book::MAGIC[8] = {'9', 'B', 'B', 'O', 'O', 'K', '\0', VERSION};
+
+namespace {
+
+// the file starts with MAGIC and then the number of entries
+struct Header {
+	char magic[8];
+	std::uint64_t count;
+};
+
+}
+
+// map the book at path, false if it can't be read or is not a book
+bool Book::open(const char *path) {
+	close();
+
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || std::size_t(st.st_size) < sizeof(Header)) {
+		::close(fd);
+		return false;
+	}
+	void *m = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (m == MAP_FAILED) return false;
+
+	const Header *header = static_cast<const Header *>(m);
+	if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+			sizeof(Header) + header->count * sizeof(std::uint64_t)
+			!= std::size_t(st.st_size)) {
+		munmap(m, st.st_size);
+		return false;
+	}
+
+	map = m;
+	mapSize = st.st_size;
+	count = header->count;
+	entries = reinterpret_cast<const std::uint64_t *>(header + 1);
+	return true;
+}
+
+void Book::close() {
+	if (map != nullptr) munmap(map, mapSize);
+	map = nullptr;
+	mapSize = 0;
+	entries = nullptr;
+	count = 0;
+}
+
+int Book::probe(std::uint64_t key) const {
+	if (entries == nullptr) return 0;
+	key &= ~MOVE_MASK;
+	const std::uint64_t *e = std::lower_bound(entries, entries + count, key);
+	if (e == entries + count || (*e & ~MOVE_MASK) != key) return 0;
+	return *e & MOVE_MASK;
+}
+
+bool Book::write(const char *path,
+		std::vector<std::pair<std::uint64_t, int> > moves) {
+	std::vector<std::uint64_t> packed;
+	for (const auto &m : moves) {
+		packed.push_back((m.first & ~MOVE_MASK) | (m.second & MOVE_MASK));
+	}
+	std::sort(packed.begin(), packed.end());
+
+	Header header;
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.count = packed.size();
+
+	std::FILE *fp = std::fopen(path, "wb");
+	if (fp == nullptr) return false;
+	bool ok = std::fwrite(&header, sizeof(header), 1, fp) == 1 &&
+			std::fwrite(packed.data(), sizeof(std::uint64_t), packed.size(),
+					fp) == packed.size();
+	return std::fclose(fp) == 0 && ok;
+}
@@ -0,0 +1,55 @@
+/*
+ * Book.h
+ *
+ * An opening book: the move to play in each position near the start of the
+ * game, found beforehand by a deep search (see agent/bench/makebook.cpp). The
+ * book is a file of 8 byte entries sorted by key, each the Zobrist key of a
+ * position (State::getKey) with its low 4 bits replaced by the move, after a
+ * 16 byte header. It is memory mapped read-only, so opening it costs nothing
+ * and a probe is a binary search.
+ *
+ * Entries are written in the byte order of the machine that built the book,
+ * and keys are only valid for the State Zobrist keys they were made with; the
+ * version in the header is raised whenever those change.
+ *
+ *  Created on: 16/10/2026
+ */
+
+#ifndef BOOK_H_
+#define BOOK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Book {
+public:
+	Book() { }
+	~Book() { close(); }
+	Book(const Book &) = delete;
+	Book &operator=(const Book &) = delete;
+
+	bool open(const char *path);
+	void close();
+	bool isOpen() const { return entries != nullptr; }
+	std::size_t size() const { return count; }
+
+	// the book move for the position with the given key, 0 if none
+	int probe(std::uint64_t key) const;
+
+	// write a book of (key, move) pairs to path, false on failure
+	static bool write(const char *path,
+			std::vector<std::pair<std::uint64_t, int> > moves);
+
+private:
+	void *map = nullptr;
+	std::size_t mapSize = 0;
+	const std::uint64_t *entries = nullptr;
+	std::size_t count = 0;
+
+	enum { VERSION = 1, MOVE_BITS = 4 };
+	static const std::uint64_t MOVE_MASK = (1 << MOVE_BITS) - 1;
+	static const char MAGIC[8];
+};
+
+#endif /* BOOK_H_ */
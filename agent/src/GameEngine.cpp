@@ -11,6 +11,21 @@
 
 #include "GameEngine.h"
 
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+// a copy of the engine searching on a thread of its own
+struct GameEngine::Ponder {
+	std::atomic<bool> stop;
+	GameEngine engine;
+	std::thread thread;
+
+	explicit Ponder(const GameEngine &ge) : stop(false), engine(ge) { }
+};
+
 // reset GameEngine state
 void GameEngine::reset() {
 	currState.clear();
@@ -18,7 +33,10 @@ void GameEngine::reset() {
 	opponent = 0;
 	move = 0;
 	cutOffDepth = 0;
-	ttable.clear();
+	stopPonder();
+	ttable->clear();
+	timer.newGame();
+	clearHeuristics();
 }
 
 // set up the game engine with the given player, must be called before starting
@@ -36,7 +54,7 @@ void GameEngine::setPlayer(int this_player) {
 // take a random move (not used)
 int GameEngine::randomMove() {
 	// get list of available moves in my sub-board
-	std::vector<int> avail = available(currState.getCurrSub());
+	MoveList avail = available(currState.getCurrSub());
 
 	// choose a random move
 	std::uniform_int_distribution<int> distribution(0,avail.size()-1);
@@ -48,33 +66,265 @@ int GameEngine::randomMove() {
 	return move;
 }
 
-// perform iterative deepening minimax search with alpha-beta pruning, starting
-// at depth depth, and ceasing based on elapsed time
+/* perform iterative deepening minimax search with alpha-beta pruning, starting
+ * at depth depth. The TimeManager decides whether there is time for each new
+ * iteration, and an iteration still running at its hard limit is abandoned. */
 int GameEngine::iterDeepSearch(int depth) {
-	unsigned long start = clock();
-	unsigned long current = clock();
-	unsigned long clocks_per_ms = (unsigned long)CLOCKS_PER_SEC / 1000ul;
-
-	// set up for move
+	/* set up for move. The transposition table is kept from earlier moves,
+	 * and while pondering, so the first iterations are mostly found there.
+	 * Pondering started this move's table generation already, so that what
+	 * it stored doesn't count as stale. */
+	bool pondered = stopPonder();
+	timer.startMove(currState.getNumMoves());
+	// it is our move, even as the first of the game, before any update
+	currState.setCurrPlayer(player);
 	move = 0;
-	ttable.clear();
+	rootValue = NO_VALUE;
+	depthReached = 0;
+	iterations = 0;
+	stats.clear();
+	aborted = false;
+	if (!pondered) ttable->newSearch();
+	ageHistory();
+
+	// take a win on the sub-board of play without searching
+	unsigned wins = currState.winCells(currState.getCurrSub(), player);
+	if (wins != 0) {
+		move = __builtin_ctz(wins) + 1;
+		rootValue = SubBoard::WIN;
+		currState.makeMove(move);
+		writeStats("win", timer.elapsed());
+		timer.endMove();
+		return move;
+	}
 
-	// perform alpha-beta searches with increasing depth
-	while (((current - start) / clocks_per_ms < DEEP_TIME_CUT) &&
-			depth <= HARD_DEPTH_LIMIT) {
+	// with only one move there is nothing to think about, save the time
+	MoveList avail = available(currState.getCurrSub());
+	if (avail.size() == 1 && depthLimit == 0 && nodeLimit == 0) {
+		move = avail[0];
+		currState.makeMove(move);
+		writeStats("forced", timer.elapsed());
+		timer.endMove();
+		return move;
+	}
+
+	/* play a book move, or near the end of the game a solved one, at once.
+	 * The time saved is banked. */
+	if (depthLimit == 0 && nodeLimit == 0) {
+		const char *source = bookMove() ? "book" : solve() ? "solver" : nullptr;
+		if (source != nullptr) {
+			currState.makeMove(move);
+			writeStats(source, timer.elapsed());
+			timer.endMove();
+			return move;
+		}
+	}
+	// the time spent trying them is not part of the first iteration's
+	timer.startSearch();
+
+	/* Lazy SMP: helper threads search the same root, half of them one level
+	 * deeper, and leave their results in the shared transposition table for
+	 * this thread to find. Only this thread's result is used. */
+	std::atomic<bool> stopHelpers(false);
+	std::vector<GameEngine> helpers(threads - 1, *this);
+	std::vector<std::thread> workers;
+	for (int i = 0; i != threads - 1; ++i) {
+		helpers[i].stopFlag = &stopHelpers;
+		workers.emplace_back(&GameEngine::helperSearch, &helpers[i],
+				depth + (i + 1) % 2);
+	}
+
+	// a fixed depth or node count search ignores the clock
+	bool timed = (depthLimit == 0 && nodeLimit == 0);
+	if (depthLimit != 0) depth = std::min(depth, depthLimit);
+	useDeadline = timed;
+	deadline = timer.getDeadline();
+
+	/* perform alpha-beta searches with increasing depth. An abandoned
+	 * iteration still gives a move if a root move was fully searched and beat
+	 * the window, see rootSearch, otherwise the last completed iteration's
+	 * move stands */
+	int best = 0;
+	while ((depthLimit ? depth <= depthLimit : !timed || best == 0
+				|| timer.startIteration())
+			&& depth <= HARD_DEPTH_LIMIT) {
 		State temp = currState;
-		move = alphaBetaSearch(temp, depth++);
-		current = clock();
+		int m = aspirationSearch(temp, depth++, best);
+		if (aborted) {
+			if (m != 0) best = m;
+			break;
+		}
+		timer.iterationDone(best != 0 && m != best);
+		best = m;
+		depthReached = depth - 1;
+		iterationNodes[iterations++] = stats.nodes;
+
+		// a proven win or loss will not change with more depth
+		if (rootValue >= SubBoard::WIN - State::MAX_MOVES ||
+				rootValue <= SubBoard::LOSS + State::MAX_MOVES) break;
+	}
+	useDeadline = false;
+
+	stopHelpers = true;
+	for (std::thread &w : workers) {
+		w.join();
+	}
+	for (const GameEngine &h : helpers) {
+		stats.add(h.stats);
 	}
 
-	// update current state with the last calculated move and return it
+	/* update current state with the last calculated move and return it. If
+	 * the time was gone before any root move was searched, any move will do */
+	move = best != 0 ? best : avail[0];
 	currState.makeMove(move);
+	writeStats("search", timer.elapsed());
+	timer.endMove();
 	return move;
 }
 
-// perform minimax search with alpha-beta pruning, limited to depth 'depth'
-int GameEngine::alphaBetaSearch(State &state, int depth) {
-	using std::vector;
+// set move to the book move for the current position, if there is one
+bool GameEngine::bookMove() {
+	if (!book) return false;
+	int m = book->probe(currState.getKey());
+	MoveList avail = available(currState.getCurrSub());
+	if (std::find(avail.begin(), avail.end(), m) == avail.end()) return false;
+	move = m;
+	return true;
+}
+
+/* if few enough squares are empty, try to solve the current position in half
+ * the time to the soft target, leaving the rest to the ordinary search. On a
+ * proven win or draw sets move and returns true; if the position is lost, or
+ * can't be solved in time, the ordinary search should choose the move (any
+ * move loses to best play, but the opponent may not find it). */
+bool GameEngine::solve() {
+	if (State::MAX_MOVES - currState.getNumMoves() > solverEmpty) return false;
+
+	if (!solver) solver = std::make_shared<Solver>();
+	currState.setCurrPlayer(player);
+	int solved;
+	auto now = std::chrono::steady_clock::now();
+	int result = solver->solve(currState, solved,
+			now + (timer.getTargetTime() - now) / 2);
+	stats.nodes += solver->getNodes();
+	if (result != Solver::WIN && result != Solver::DRAW) return false;
+
+	move = solved;
+	rootValue = (result == Solver::WIN) ? int(SubBoard::WIN) : 0;
+	return true;
+}
+
+/* Once our move is made, carry on searching while the opponent thinks. The
+ * search assumes the opponent makes the reply we expect and runs on a copy of
+ * this engine, sharing the transposition table, until stopPonder is called.
+ * If the opponent does make that reply the next search finds its tree already
+ * in the table, and if not much of it is still useful.
+ */
+void GameEngine::startPonder(int depth) {
+	stopPonder();
+	int reply = expectedReply();
+	if (reply == 0) return;
+
+	ttable->newSearch();
+	ponder = std::make_shared<Ponder>(*this);
+	ponder->engine.stopFlag = &ponder->stop;
+	ponder->engine.currState.makeMove(reply);
+	ponder->thread = std::thread(&GameEngine::helperSearch, &ponder->engine,
+			depth);
+}
+
+/* stop pondering, if we are, and wait for the search thread to finish. True
+ * if we were pondering. */
+bool GameEngine::stopPonder() {
+	if (!ponder) return false;
+	ponder->stop = true;
+	ponder->thread.join();
+	ponder.reset();
+	return true;
+}
+
+/* the opponent's best reply in the current state according to the
+ * transposition table, or failing that the first available move. 0 if the
+ * game is over. */
+int GameEngine::expectedReply() {
+	if (currState.isDecided()) return 0;
+	MoveList avail = available(currState.getCurrSub());
+	if (avail.empty()) return 0;
+
+	TTable::Record rec;
+	if (ttable->probe(currState.getKey(), rec) &&
+			std::find(avail.begin(), avail.end(), rec.move) != avail.end()) {
+		return rec.move;
+	}
+	return avail[0];
+}
+
+// iterative deepening for a helper thread, until told to stop
+void GameEngine::helperSearch(int depth) {
+	aborted = false;
+	stats.clear();
+	while (!aborted && depth <= HARD_DEPTH_LIMIT) {
+		State temp = currState;
+		alphaBetaSearch(temp, depth++);
+	}
+}
+
+/* count a node, stopping at the node limit if there is one, and every
+ * POLL_NODES nodes check if we have been told to stop or have run out of
+ * time */
+bool GameEngine::checkAbort() {
+	if (++stats.nodes == nodeLimit) aborted = true;
+	if ((stats.nodes & (POLL_NODES - 1)) == 0) {
+		if (stopFlag != nullptr && stopFlag->load(std::memory_order_relaxed)) {
+			aborted = true;
+		}
+		if (useDeadline && std::chrono::steady_clock::now() >= deadline) {
+			aborted = true;
+		}
+	}
+	return aborted;
+}
+
+/* Search the root with a window centred on the value of the previous
+ * iteration, whose best move was prevBest (0 for the first iteration, which
+ * uses a full window). If the value falls outside the window the window is
+ * widened on that side and the root searched again. */
+int GameEngine::aspirationSearch(State &state, int depth, int prevBest) {
+	using std::max;
+	using std::min;
+
+	if (prevBest == 0) return rootSearch(state, depth, -INF, INF, 0);
+
+	int window = ASPIRATION_WINDOW;
+	int alpha = max(-INF, rootValue - window);
+	int beta = min(int(INF), rootValue + window);
+	while (true) {
+		int m = rootSearch(state, depth, alpha, beta, prevBest);
+		if (aborted || m == 0) return m;
+
+		window *= 2;
+		if (rootValue <= alpha && alpha > -INF) {
+			alpha = max(-INF, rootValue - window);
+		}
+		else if (rootValue >= beta && beta < INF) {
+			beta = min(int(INF), rootValue + window);
+			prevBest = m;
+		}
+		else {
+			return m;
+		}
+	}
+}
+
+/* principal variation search of the root, limited to depth 'depth', within
+ * the window (alpha, beta). firstMove (if available) is searched first: when
+ * it is the best move of the previous iteration, an aborted search's best
+ * move so far is at least as good. A move that fails low has only an upper
+ * bound, which can't be compared with another's, so only a move that beats
+ * alpha replaces the first. Sets rootValue and returns the best move, or 0 if
+ * aborted before any move beat alpha. */
+int GameEngine::rootSearch(State &state, int depth, int alpha, int beta,
+		int firstMove) {
 	using std::max;
 
 	// set cut-off depth and current player
@@ -82,36 +332,46 @@ int GameEngine::alphaBetaSearch(State &state, int depth) {
 	state.setCurrPlayer(player);
 
 	// get ordered list of available moves
-	vector<move_val_t> moves;
+	MoveValList moves;
 	moveOrder(state, 0, moves);
+	for (auto iter = moves.begin(); iter != moves.end(); ++iter) {
+		if (iter->move == firstMove) {
+			std::rotate(moves.begin(), iter, iter + 1);
+			break;
+		}
+	}
 
-	// get value of each move
-	int v = 0;
-	int alpha = std::numeric_limits<int>::min();
-	int beta = std::numeric_limits<int>::max();
-	int vMax = std::numeric_limits<int>::min();
-	vector<int> move_values;
+	const int alphaOrig = alpha;
+	int vMax = -INF;
+	int best = 0;
 	for (move_val_t mv : moves) {
-		State nextState = state;
-		nextState.makeMove(mv.move);
-
-		// pass control to MIN
-		v = minValue(nextState, alpha, beta, 1);
+		state.makeMove(mv.move);
+		int v = pvsChild(state, alpha, beta, 1, best == 0);
+		state.unmakeMove();
+		if (aborted) break;
 
-		// keep note of best move and move values
+		// keep note of best move
+		if (v > alpha || best == 0) best = mv.move;
 		vMax = max(vMax, v);
-		move_values.push_back(v);
 
-		// update alpha
+		// update alpha, stopping if we are above the window
 		alpha = max(alpha, v);
+		if (alpha >= beta) break;
 	}
 
-	// vMax is now the value of the best move, choose the move with this value
-	auto iter = std::find(move_values.begin(), move_values.end(), vMax);
-	move = moves[std::distance(move_values.begin(),iter)].move;
+	if (aborted && alpha == alphaOrig) return 0;
+
+	// if every move failed low, the value is at most the highest bound
+	if (best != 0) rootValue = alpha > alphaOrig ? alpha : vMax;
+	return best;
+}
+
+// perform minimax search with alpha-beta pruning, limited to depth 'depth'
+int GameEngine::alphaBetaSearch(State &state, int depth) {
+	move = rootSearch(state, depth, -INF, INF, 0);
 
 	// update board and return move
-	state.makeMove(move);
+	if (move != 0) state.makeMove(move);
 
 	return move;
 }
@@ -121,253 +381,313 @@ int GameEngine::alphaBetaSearch(int depth) {
 	return alphaBetaSearch(currState, depth);
 }
 
-// the MAX side of minimax
-int GameEngine::maxValue(State &state, int alpha, int beta, int depth) {
-	using std::vector;
+/* value of the state reached by a move, from the point of view of the player
+ * who made it. The first move of a node is searched with the full window;
+ * later ones first with a null window, to show cheaply that they are no better
+ * than alpha, and again with the full window only if that fails. A late move
+ * may first be searched reduction plies shallower, again with a null window,
+ * and is searched at its proper depth only if it beats alpha. The reduction
+ * lowers the cutoff for that subtree rather than raising depth, which stays
+ * the true ply for the killer moves and the history. */
+int GameEngine::pvsChild(State &state, int alpha, int beta, int depth,
+		bool first, int reduction) {
+	if (first) return -negamax(state, -beta, -alpha, depth);
+
+	int v;
+	if (reduction > 0) {
+		COUNT_STAT(stats.reductions);
+		cutOffDepth -= reduction;
+		v = -negamax(state, -alpha - 1, -alpha, depth);
+		cutOffDepth += reduction;
+		if (v <= alpha || aborted) return v;
+		COUNT_STAT(stats.reSearches);
+	}
+
+	v = -negamax(state, -alpha - 1, -alpha, depth);
+	if (v > alpha && v < beta && !aborted) {
+		v = -negamax(state, -beta, -alpha, depth);
+	}
+	return v;
+}
+
+/* negamax form of minimax with alpha-beta pruning: values are from the point
+ * of view of the player to move in state, and each side maximises the
+ * negation of the values of the states its moves lead to */
+int GameEngine::negamax(State &state, int alpha, int beta, int depth) {
 	using std::max;
 	using std::min;
 
+	if (checkAbort()) return 0;
+
+	/* a move completing a line on the sub-board of play wins at once, so it
+	 * is taken without search, even at the cutoff. The threat table finds
+	 * one with a single lookup. */
+	if (!state.isDecided() &&
+			state.winCells(state.getCurrSub(), state.getCurrPlayer()) != 0) {
+		return SubBoard::WIN - (state.getNumMoves() + 1);
+	}
+
+	std::uint64_t key = state.getKey();
+	int alphaOrig = alpha;
+
 	// see if an entry for this state exists in transposition table
-	auto iter = ttable.find(state);
-	if (iter != ttable.end()) {
+	TTable::Record rec;
+	int hashMove = 0;
+	COUNT_STAT(stats.ttProbes);
+	if (ttable->probe(key, rec)) {
+		COUNT_STAT(stats.ttHits);
+		hashMove = rec.move;
 		// if current relative depth <= stored state relative depth we can use
-		if (cutOffDepth - depth <= iter->getRelDepth()) {
-			int valType = iter->getValueType();
+		if (cutOffDepth - depth <= rec.relDepth) {
 			// if the state has an exact value, return it
-			if (valType == State::EXACT) {
-				return iter->getValue();
+			if (rec.valueType == TTable::EXACT) {
+				return rec.value;
 			}
 			// if the state has an upper bound, use it to set beta
-			if (valType == State::UPPER_BOUND) {
-				beta = min(iter->getValue(), beta);
+			if (rec.valueType == TTable::UPPER_BOUND) {
+				beta = min(rec.value, beta);
 			}
 			// if the state has a lower bound, use it to set alpha
-			if (valType == State::LOWER_BOUND) {
-				alpha = max(iter->getValue(), alpha);
+			if (rec.valueType == TTable::LOWER_BOUND) {
+				alpha = max(rec.value, alpha);
 			}
+			if (alpha >= beta) return rec.value;
 		}
 	}
 
 	// check if a terminal condition exists
 	if (cutoffTest(state,depth)) {
 		// we have an exact value for the transposition table
-		if (iter != ttable.end()) {
-			// state already exists in table, update it
-			iter->setValue(iter->utility(player, depth));
-			iter->setValueType(State::EXACT);
-			iter->setRelDepth(cutOffDepth - depth);
-			return iter->getValue();
-		} else {
-			// state is new, add to table
-			state.setValue(state.utility(player, depth));
-			state.setValueType(State::EXACT);
-			state.setRelDepth(cutOffDepth - depth);
-			ttable.insert(state);
-			return state.getValue();
-		}
+		int v = state.utility(state.getCurrPlayer(), state.getNumMoves());
+		COUNT_STAT(stats.evals);
+		store(key, v, TTable::EXACT, leafDepth(depth), 0);
+		return v;
 	}
 
-	// get an ordered list of available moves
-	vector<move_val_t> moves;
-	moveOrder(state, depth, moves);
+	/* the best move stored for this state is searched first, on its own, and
+	 * the rest are only generated and ordered if it does not cause a cutoff */
+	MoveValList moves;
+	if (hashMove != 0 &&
+			state.query(state.getCurrSub(), hashMove) == SubBoard::BLANK) {
+		moves.push_back(move_val_t{hashMove, 0, 0});
+	}
+	else {
+		hashMove = 0;
+	}
+	bool ordered = false;
+
+	/* near the cutoff, moves that can't reach alpha by the evaluation are
+	 * pruned, unless either side is winning */
+	int remaining = cutOffDepth - depth;
+	bool prune = futility && remaining <= FUTILITY_DEPTH &&
+			alpha > SubBoard::LOSS + State::MAX_MOVES &&
+			alpha < SubBoard::WIN - State::MAX_MOVES;
+	int margin = FUTILITY_MARGIN * remaining;
+	int staticVal = prune ?
+			state.utility(state.getCurrPlayer(), state.getNumMoves()) : 0;
 
 	// find best value for available moves
-	int v = std::numeric_limits<int>::min();
-	for (move_val_t mv : moves) {
-		State nextState = state;
-		nextState.makeMove(mv.move);
+	int v = -INF;
+	int best = 0;
+	for (int i = 0; ; ++i) {
+		if (i == moves.size()) {
+			if (ordered) break;
+			moveOrder(state, depth, moves, hashMove);
+			ordered = true;
+			if (i == moves.size()) break;
+		}
+		move_val_t mv = moves[i];
+
+		// killers and winning moves are never pruned or reduced
+		bool quiet = (mv.val < (HISTORY_MAX - 2) * STATIC_RANGE);
+		if (prune && best != 0 && quiet &&
+				staticVal + mv.gain + margin <= alpha) {
+			COUNT_STAT(stats.futilityPrunes);
+			v = max(v, staticVal + mv.gain + margin);
+			continue;
+		}
+		int reduction = 0;
+		if (reductions && i >= LMR_MOVES && quiet &&
+				remaining >= LMR_MIN_DEPTH) {
+			reduction = (i >= LMR_DEEP_MOVES && remaining > LMR_MIN_DEPTH)
+					? 2 : 1;
+		}
 
-		// pass control to MIN
-		v = max(v, minValue(nextState, alpha, beta, depth + 1));
+		state.makeMove(mv.move);
+		int childVal = pvsChild(state, alpha, beta, depth + 1, best == 0,
+				reduction);
+		state.unmakeMove();
+		if (aborted) return 0;
+
+		bool first = (best == 0);
+		if (childVal > v || first) {
+			v = childVal;
+			best = mv.move;
+		}
 
 		// prune if v greater than beta
-		if (v >= beta) break;
+		if (v >= beta) {
+			COUNT_STAT(stats.cutoffs);
+			if (first) COUNT_STAT(stats.firstCutoffs);
+			recordCutoff(state, mv.move, depth);
+			break;
+		}
 
 		// update alpha
 		alpha = max(alpha, v);
 	}
 
-	// we now have an upper bound on v, update t-table
-	if (iter != ttable.end()) {
-		iter->setValue(v);
-		iter->setValueType(State::UPPER_BOUND);
-		iter->setRelDepth(cutOffDepth - depth);
-	} else {
-		state.setValue(v);
-		state.setValueType(State::UPPER_BOUND);
-		state.setRelDepth(cutOffDepth - depth);
-		ttable.insert(state);
-	}
+	// v is exact only if it fell inside the original window
+	int valType = TTable::EXACT;
+	if (v <= alphaOrig) valType = TTable::UPPER_BOUND;
+	else if (v >= beta) valType = TTable::LOWER_BOUND;
+	store(key, v, valType, cutOffDepth - depth, best);
 
 	return v;
 }
 
-// the MIN side of minimax
-int GameEngine::minValue(State &state, int alpha, int beta, int depth) {
-	using std::vector;
-	using std::min;
-	using std::max;
-
-	// see if an entry for this state exists in transposition table
-	auto iter = ttable.find(state);
-	if (iter != ttable.end()) {
-		// if current relative depth <= stored state relative depth we can use
-		if (cutOffDepth - depth <= iter->getRelDepth()) {
-			int valType = iter->getValueType();
-			// if the state has an exact value, return it
-			if (valType == State::EXACT) {
-				return iter->getValue();
-			}
-			// if the state has an upper bound, use it to set beta
-			if (valType == State::UPPER_BOUND) {
-				beta = min(iter->getValue(), beta);
-			}
-			// if the state has a lower bound, use it to set alpha
-			if (valType == State::LOWER_BOUND) {
-				alpha = max(iter->getValue(), alpha);
-			}
-		}
+// store a result in the transposition table, counting stores and overwrites
+void GameEngine::store(std::uint64_t key, int value, int valueType,
+		int relDepth, int move) {
+	COUNT_STAT(stats.ttStores);
+	if (ttable->store(key, value, valueType, relDepth, move)) {
+		COUNT_STAT(stats.ttOverwrites);
 	}
+}
 
-	if (cutoffTest(state,depth)) {
-		// we have an exact value for the transposition table
-		if (iter != ttable.end()) {
-			iter->setValue(iter->utility(player, depth));
-			iter->setValueType(State::EXACT);
-			iter->setRelDepth(cutOffDepth - depth);
-			return iter->getValue();
-		} else {
-			state.setValue(state.utility(player, depth));
-			state.setValueType(State::EXACT);
-			state.setRelDepth(cutOffDepth - depth);
-			ttable.insert(state);
-			return state.getValue();
-		}
-	}
-
-	int v = std::numeric_limits<int>::max();
-
-	// determine the minimum attainable value given available moves
-
-	// get an ordered list of available moves
-	vector<move_val_t> moves;
-	moveOrder(state, depth, moves);
-
-	for (move_val_t mv : moves) {
-		State nextState = state;
-		nextState.makeMove(mv.move);
-
-		v = min(v, maxValue(nextState, alpha, beta, depth + 1));
+/* termination test for minimax search: the depth cutoff, or the end of the
+ * game by a won sub-board or by play sent to a full one */
+int GameEngine::cutoffTest(State &state, int depth) {
+	return depth == cutOffDepth || state.isOver();
+}
 
-		if (v <= alpha) break;
+/* height to record for a node that cutoffTest has ended. A finished game has
+ * the same value whatever the depth cutoff, so it is kept at maximum height
+ * and never searched again. */
+int GameEngine::leafDepth(int depth) const {
+	if (depth < cutOffDepth) return TTable::MAX_DEPTH;
+	return 0;
+}
 
-		beta = min(beta, v);
+/* accepts a State, a current depth, a reference to a list of move_val_t and
+ * a move already searched (0 if none). Appends the other available moves,
+ * reverse sorted on value, ordered by killer and history heuristics.
+ */
+void GameEngine::moveOrder(State &s, int depth, MoveValList &moveVals,
+		int skip) {
+	int start = moveVals.size();
+	int sub = s.getCurrSub();
+	int mover = s.getCurrPlayer();
+
+	// every child's sub-board evaluation in one go
+	int values[9];
+	s.evaluateMoves(sub, mover, values);
+	int sign = (mover == SubBoard::X_MARK) ? 1 : -1;
+	int before = sign * s.evaluate(sub);
+
+	for (int move : s.available(sub)) {
+		if (move == skip) continue;
+		int after = sign * values[move - 1];
+		int gain = after - before;
+		int val;
+		if (after == SubBoard::WIN) val = WINNING_MOVE;
+		else {
+			val = heuristicScore(s, move, depth) * STATIC_RANGE + std::min(
+					std::max(gain + STATIC_RANGE / 2, 0), STATIC_RANGE - 1);
+		}
+		moveVals.push_back(move_val_t{move, val, gain});
 	}
 
-	// we now have a lower bound on v, update t-table
-	if (iter != ttable.end()) {
-		iter->setValue(v);
-		iter->setValueType(State::LOWER_BOUND);
-		iter->setRelDepth(cutOffDepth - depth);
-	} else {
-		state.setValue(v);
-		state.setValueType(State::LOWER_BOUND);
-		state.setRelDepth(cutOffDepth - depth);
-		ttable.insert(state);
-	}
+	// reverse sort new moves by value (see state_move_t definition)
+	std::sort(moveVals.begin() + start, moveVals.end());
+}
 
-	return v;
+// forget all killer moves and history
+void GameEngine::clearHeuristics() {
+	std::fill(&killers[0][0], &killers[0][0] + sizeof(killers) / sizeof(int), 0);
+	std::fill(&history[0][0][0],
+			&history[0][0][0] + sizeof(history) / sizeof(int), 0);
 }
 
-// termination test for minimax search
-int GameEngine::cutoffTest(State &state, int depth) {
-	if (depth == cutOffDepth) return true;
-
-	// see if state is in ttable
-	auto iter = ttable.find(state);
-	if (iter != ttable.end()) {
-		if (iter->utility(player,depth) >= SubBoard::WIN - HARD_DEPTH_LIMIT ||
-				iter->utility(player, depth) <=
-				SubBoard::LOSS + HARD_DEPTH_LIMIT)
-			return true;
-	}
-	else {
-		// state is not in ttable
-		if (state.utility(player, depth) >= SubBoard::WIN - HARD_DEPTH_LIMIT ||
-				state.utility(player, depth) <=
-				SubBoard::LOSS + HARD_DEPTH_LIMIT) {
-			// add state to table for future reference
-			ttable.insert(state);
-			return true;
-		}
+// halve the history scores at each new search, so recent results count more
+void GameEngine::ageHistory() {
+	for (int *h = &history[0][0][0];
+			h != &history[0][0][0] + sizeof(history) / sizeof(int); ++h) {
+		*h /= 2;
 	}
-	return false;
 }
 
-/* accepts a State, a current depth, and a reference to a vector of move_val_t.
- * returns a vector of move_val_t, reverse sorted on value.
- */
-void GameEngine::moveOrder(const State &s, int depth,
-		std::vector<move_val_t> &moveVals) {
-	using std::vector;
-	using std::min;
-	using std::max;
-
-	vector<int> avail = s.available(s.getCurrSub());
-	moveVals.clear();
-
-	for (int move : avail) {
-		State nextState = s;
-
-		// make the move
-		nextState.makeMove(move);
-		move_val_t thisMoveVal{move, 0};
-
-		/* move ordering reduces in value with depth, just return available
-		 * moves. */
-		if (depth >= MOVE_ORDER_DEPTH_LIMIT) {
-			moveVals.push_back(thisMoveVal);
-			continue;
-		}
-
-		// check if state has been found before, if so use its value
-		auto iter = ttable.find(nextState);
-		if (iter != ttable.end()) {
-			int valType = iter->getValueType();
-			if (valType == State::EXACT) {
-				// use the previously determined value
-				thisMoveVal.val = iter->getValue();
-			}
-			else if (valType == State::UPPER_BOUND) {
-				// use 0 if within bound, otherwise use bound
-				thisMoveVal.val = min(0,
-						iter->getValue());
-			}
-			else if (valType == State::LOWER_BOUND) {
-				// use 0 if within bound, otherwise use bound
-				thisMoveVal.val = max(0,
-						iter->getValue());
-			}
-			else {
-				// use 0
-				thisMoveVal.val = 0;
-			}
-		}
-		else {
-			// state has not been found before, use 0
-			thisMoveVal.val = 0;
-		}
-		// keep the moves and values in a vector
-		moveVals.push_back(thisMoveVal);
+// note a move that caused a beta cutoff in state at depth depth
+void GameEngine::recordCutoff(const State &s, int move, int depth) {
+	int killer = s.getCurrSub() * 16 + move;
+	if (killers[depth][0] != killer) {
+		killers[depth][1] = killers[depth][0];
+		killers[depth][0] = killer;
 	}
 
-	// reverse sort available moves by value (see state_move_t definition)
-	if (depth < MOVE_ORDER_DEPTH_LIMIT) {
-		std::sort(moveVals.begin(), moveVals.end());
-	}
+	int remaining = cutOffDepth - depth;
+	int &h = history[s.getCurrSub() - 1][move - 1][s.getCurrPlayer() - 1];
+	h += remaining * remaining;
+	if (h >= HISTORY_MAX - 2) ageHistory();
+}
+
+/* ordering score of a move from the killer moves and history, killers first;
+ * always less than HISTORY_MAX */
+int GameEngine::heuristicScore(const State &s, int move, int depth) const {
+	int killer = s.getCurrSub() * 16 + move;
+	if (killers[depth][0] == killer) return HISTORY_MAX - 1;
+	if (killers[depth][1] == killer) return HISTORY_MAX - 2;
+	return history[s.getCurrSub() - 1][move - 1][s.getCurrPlayer() - 1];
 }
 
 // print the state, not used
 void GameEngine::printState() {
 	std::cout << currState << std::endl;
 }
+
+/* report the move just made as one line of JSON to statsFd: how it was
+ * chosen (search, book, solver, win or forced), the time taken, the depth,
+ * the value (left out for a move that has none, such as a book move), the
+ * search counters and, for each iteration, its nodes and their ratio to the
+ * last iteration's (the effective branching factor) */
+void GameEngine::writeStats(const char *source, long ms) {
+	if (statsFd < 0) return;
+
+	std::ostringstream os;
+	os << "{\"ply\":" << currState.getNumMoves()
+			<< ",\"move\":" << move
+			<< ",\"source\":\"" << source << "\""
+			<< ",\"ms\":" << ms
+			<< ",\"depth\":" << depthReached;
+	if (rootValue != NO_VALUE) os << ",\"value\":" << rootValue;
+	os << ",\"nodes\":" << stats.nodes
+			<< ",\"nps\":" << (ms > 0 ? stats.nodes * 1000 / ms : 0)
+			<< ",\"evals\":" << stats.evals
+			<< ",\"tt_probes\":" << stats.ttProbes
+			<< ",\"tt_hits\":" << stats.ttHits
+			<< ",\"tt_stores\":" << stats.ttStores
+			<< ",\"tt_overwrites\":" << stats.ttOverwrites
+			<< ",\"cutoffs\":" << stats.cutoffs
+			<< ",\"reductions\":" << stats.reductions
+			<< ",\"re_searches\":" << stats.reSearches
+			<< ",\"futility_prunes\":" << stats.futilityPrunes
+			<< ",\"first_cutoff_rate\":" << stats.firstCutoffRate();
+
+	unsigned long perIteration[HARD_DEPTH_LIMIT + 1];
+	for (int i = 0; i != iterations; ++i) {
+		perIteration[i] = iterationNodes[i] - (i > 0 ? iterationNodes[i - 1] : 0);
+	}
+	os << ",\"iteration_nodes\":[";
+	for (int i = 0; i != iterations; ++i) {
+		os << (i > 0 ? "," : "") << perIteration[i];
+	}
+	os << "],\"ebf\":[";
+	for (int i = 1; i < iterations; ++i) {
+		os << (i > 1 ? "," : "")
+				<< double(perIteration[i]) / std::max(1ul, perIteration[i - 1]);
+	}
+	os << "]}\n";
+
+	std::string line = os.str();
+	if (::write(statsFd, line.data(), line.size()) < 0) statsFd = -1;
+}
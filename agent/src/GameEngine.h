@@ -9,37 +9,117 @@
 #define GAMEENGINE_H_
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <ctime>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <random>
-#include <unordered_set>
 #include <vector>
 
+#include "Book.h"
+#include "Solver.h"
 #include "State.h"
+#include "TimeManager.h"
+#include "TTable.h"
 
 
 struct move_val_t {
 	int move;
 	int val;
+	int gain; // change to the mover's utility, see GameEngine::moveOrder
 
 	bool operator<(const move_val_t &rhs) const {
 		return val > rhs.val; // note will reverse sort on val
 	}
 };
 
+// moves of a node with their ordering scores
+typedef FixedList<move_val_t, MoveList::CAPACITY> MoveValList;
+
+/* Counters kept by the search, for tuning. The node count is always kept, as
+ * the search needs it; the rest only if SEARCH_STATS is non-zero (the
+ * default), so that building with -DSEARCH_STATS=0 removes them entirely. */
+#ifndef SEARCH_STATS
+#define SEARCH_STATS 1
+#endif
+#if SEARCH_STATS
+#define COUNT_STAT(counter) (++(counter))
+#else
+#define COUNT_STAT(counter) ((void)0)
+#endif
+
+struct SearchStats {
+	unsigned long nodes = 0;
+	unsigned long evals = 0; // leaves scored by the heuristic
+	unsigned long cutoffs = 0; // beta cutoffs
+	unsigned long firstCutoffs = 0; // beta cutoffs on the first move searched
+	unsigned long ttProbes = 0; // transposition table lookups
+	unsigned long ttHits = 0; // lookups that found the state
+	unsigned long ttStores = 0;
+	unsigned long ttOverwrites = 0; // stores replacing another state's record
+	unsigned long reductions = 0; // late moves searched shallower
+	unsigned long reSearches = 0; // of those, searched again at full depth
+	unsigned long futilityPrunes = 0; // moves not searched at all
+
+	void clear() { *this = SearchStats(); }
+	void add(const SearchStats &s) {
+		nodes += s.nodes;
+		evals += s.evals;
+		cutoffs += s.cutoffs;
+		firstCutoffs += s.firstCutoffs;
+		ttProbes += s.ttProbes;
+		ttHits += s.ttHits;
+		ttStores += s.ttStores;
+		ttOverwrites += s.ttOverwrites;
+		reductions += s.reductions;
+		reSearches += s.reSearches;
+		futilityPrunes += s.futilityPrunes;
+	}
+	double firstCutoffRate() const {
+		return cutoffs ? double(firstCutoffs) / cutoffs : 0;
+	}
+	double ttHitRate() const {
+		return ttProbes ? double(ttHits) / ttProbes : 0;
+	}
+};
+
+/* Copies of a GameEngine share its transposition table; this is how the helper
+ * threads of iterDeepSearch see each other's results.
+ */
 class GameEngine {
 public:
-	GameEngine() {
+	explicit GameEngine(int hashMB = TTable::DEFAULT_MB)
+			: ttable(std::make_shared<TTable>(hashMB)) {
 		generator.seed(clock());
+		clearHeuristics();
 	}
+	~GameEngine() { stopPonder(); }
 	void setPlayer(int);
 	void setMove(int m) { move = m; }
 	void setCurrSub(int s) { currState.setCurrSub(s); }
+	void setHashSize(int mb) { ttable->resize(mb); }
+	void setHashSizeKB(int kb) { ttable->resizeKB(kb); }
+	void setThreads(int n) { threads = std::max(1, n); }
+	void setDepthLimit(int d) { depthLimit = d; }
+	void setNodeLimit(unsigned long n) { nodeLimit = n; }
+	void setSolverEmpty(int n) { solverEmpty = n; }
+	void setSolver(std::shared_ptr<Solver> s) { solver = s; }
+	void setReductions(bool on) { reductions = on; }
+	void setFutility(bool on) { futility = on; }
+	void setBook(std::shared_ptr<const Book> b) { book = b; }
+	void setStatsFd(int fd) { statsFd = fd; }
+	void setMoveTime(int ms) { timer.setMoveTime(ms); }
+	void setGameTime(int ms) { timer.setGameTime(ms); }
 
 	int getOpponent() { return opponent; }
 	int getPlayer() { return player; }
 	int getMove() { return move; }
+	unsigned long getNodes() { return stats.nodes; }
+	int getDepth() { return depthReached; }
+	std::uint64_t getKey() { return currState.getKey(); }
+	const SearchStats &getStats() { return stats; }
 
 	void reset();
 	void update(int board, int pos, int val) {
@@ -47,18 +127,23 @@ public:
 		currState.setCurrPlayer(val);
 		currState.makeMove(pos);
 	}
-	std::vector<int> available(int board) { return currState.available(board); }
+	MoveList available(int board) { return currState.available(board); }
 
 	int randomMove();
 	int iterDeepSearch(int startDepth);
+	void startPonder(int startDepth);
+	bool stopPonder();
 	int alphaBetaSearch(State &state, int depth);
 	int alphaBetaSearch(int depth);
-	int maxValue(State &s, int alpha, int beta, int depth);
-	int minValue(State &s, int alpha, int beta, int depth);
+	int negamax(State &s, int alpha, int beta, int depth);
 	int cutoffTest(State &s, int depth);
 
 	void printState();
 
+	/* experimentally, most positions with this many empty squares are solved
+	 * in a few tens of ms */
+	enum { DEFAULT_SOLVER_EMPTY = 52 };
+
 private:
 	State currState;
 	int player = 0;
@@ -66,16 +151,106 @@ private:
 	int move = 0;
 	int cutOffDepth = 0;
 	std::default_random_engine generator;
-	std::unordered_set<State> ttable; // this is a hash table
+	std::shared_ptr<TTable> ttable;
+	int threads = 1; // total search threads, including this one
+	int depthLimit = 0; // if set, search to exactly this depth ignoring time
+	unsigned long nodeLimit = 0; // if set, stop after this many nodes instead
+	int depthReached = 0; // depth of the last completed iteration
+
+	/* positions with at most solverEmpty empty squares are first given to the
+	 * solver, which is created when first needed unless one is set (a
+	 * server's worker shares its solver between the games it plays) */
+	int solverEmpty = DEFAULT_SOLVER_EMPTY;
+	std::shared_ptr<Solver> solver;
+	bool solve();
+
+	// moves for positions near the start of the game, see Book.h
+	std::shared_ptr<const Book> book;
+	bool bookMove();
+
+	TimeManager timer;
+	// value of the move chosen, NO_VALUE if not searched (book, forced)
+	int rootValue = NO_VALUE;
+
+	// search abort, when helper threads are stopped or time runs out
+	const std::atomic<bool> *stopFlag = nullptr;
+	bool useDeadline = false;
+	std::chrono::steady_clock::time_point deadline;
+	bool aborted = false;
+	SearchStats stats;
+
+	// background search during the opponent's turn, see startPonder
+	struct Ponder;
+	std::shared_ptr<Ponder> ponder;
+
+	// time for each move is decided by the TimeManager
+	enum { HARD_DEPTH_LIMIT = 20 };
+
+	/* search values lie within +/- INF, which must fit in the transposition
+	 * table's 16 bits. An iteration first searches ASPIRATION_WINDOW either
+	 * side of the previous iteration's value. */
+	enum { INF = 30000, ASPIRATION_WINDOW = 25 };
+	enum { NO_VALUE = -INF - 1 };
+
+	/* stop flag and clock are read once every POLL_NODES nodes, must be a
+	 * power of 2 */
+	enum { POLL_NODES = 1024 };
+
+	/* move ordering heuristics: two killer moves (the last moves to cause a
+	 * cutoff) for each depth, as sub-board * 16 + position, and a history
+	 * score for each position on each sub-board for each player, raised by
+	 * the square of the remaining depth at every cutoff. History scores are
+	 * kept below HISTORY_MAX, above which the killers are scored. */
+	enum { HISTORY_MAX = 1 << 10 };
+
+	/* moveOrder breaks ties in the heuristic score with the change the move
+	 * makes to its sub-board's evaluation, clamped to STATIC_RANGE values,
+	 * and puts a move that wins its sub-board (and so the game) first */
+	enum { STATIC_RANGE = 1 << 6,
+		WINNING_MOVE = HISTORY_MAX * STATIC_RANGE };
+	int killers[HARD_DEPTH_LIMIT + 1][2];
+	int history[9][9][2];
+
+	/* selective search, each part of which can be turned off. Late move
+	 * reductions: a move ordered LMR_MOVES or later, neither a killer nor a
+	 * win, at a node at least LMR_MIN_DEPTH plies from the cutoff, is first
+	 * searched one ply shallower (two once LMR_DEEP_MOVES have been) with a
+	 * null window, and searched properly only if it beats alpha. Futility
+	 * pruning: within FUTILITY_DEPTH plies of the cutoff, a move whose value
+	 * by the evaluation after it falls short of alpha by FUTILITY_MARGIN for
+	 * each ply left is not searched at all. Reductions are off by default:
+	 * in self-play at equal nodes the tactics they miss cost as much as the
+	 * depth they gain is worth. */
+	enum { LMR_MOVES = 3, LMR_DEEP_MOVES = 6, LMR_MIN_DEPTH = 3 };
+	enum { FUTILITY_DEPTH = 2, FUTILITY_MARGIN = 20 };
+	bool reductions = false;
+	bool futility = true;
+
+	/* nodes searched by this thread at the end of each iteration of the
+	 * current move, and the file descriptor to report each move to as a line
+	 * of JSON (-1 for none), see writeStats */
+	unsigned long iterationNodes[HARD_DEPTH_LIMIT + 1];
+	int iterations = 0;
+	int statsFd = -1;
+	void writeStats(const char *source, long ms);
+
+	void clearHeuristics();
+	void ageHistory();
+	void recordCutoff(const State &, int move, int depth);
+	int heuristicScore(const State &, int move, int depth) const;
 
-	/* experimentally, each level of tree takes 3x longer than sum of
-	 * all previous levels. With a bit of tweaking, 1000ms seems a good time cut
-	 * to give an average time per move of around 2s.
-	 */
-	enum { DEEP_TIME_CUT = 100, HARD_DEPTH_LIMIT = 20,
-		MOVE_ORDER_DEPTH_LIMIT = 7 };
+	void helperSearch(int depth);
+	int aspirationSearch(State &, int depth, int prevBest);
+	int rootSearch(State &, int depth, int alpha, int beta, int firstMove);
+	int pvsChild(State &, int alpha, int beta, int depth, bool first,
+			int reduction = 0);
+	int expectedReply();
+	bool checkAbort();
 
-	void moveOrder(const State &, int depth, std::vector<move_val_t> &);
+	void moveOrder(State &, int depth, MoveValList &, int skip = 0);
+	int leafDepth(int depth) const;
+	void store(std::uint64_t key, int value, int valueType, int relDepth,
+			int move);
 };
 
 
@@ -0,0 +1,51 @@
+/*
+ * MoveList.h
+ *
+ * Lists of moves held in a fixed size array on the stack, so that generating,
+ * ordering and iterating the moves of a node never allocates. A sub-board has
+ * at most nine moves. A MoveList of positions is built from a SubBoard's
+ * 9 bit mask of empty positions by taking the lowest set bit each time.
+ *
+ *  Created on: 16/10/2026
+ */
+
+#ifndef MOVELIST_H_
+#define MOVELIST_H_
+
+template <typename T, int N>
+class FixedList {
+public:
+	void push_back(const T &t) { items[count++] = t; }
+	void clear() { count = 0; }
+
+	int size() const { return count; }
+	bool empty() const { return count == 0; }
+	T &operator[](int i) { return items[i]; }
+	const T &operator[](int i) const { return items[i]; }
+
+	T *begin() { return items; }
+	T *end() { return items + count; }
+	const T *begin() const { return items; }
+	const T *end() const { return items + count; }
+
+	enum { CAPACITY = N };
+
+private:
+	T items[N];
+	int count = 0;
+};
+
+// positions 1 to 9 of a sub-board
+class MoveList : public FixedList<int, 9> {
+public:
+	MoveList() {}
+
+	// the positions whose bits (bit pos - 1) are set in mask
+	explicit MoveList(unsigned mask) {
+		for (; mask != 0; mask &= mask - 1) {
+			push_back(__builtin_ctz(mask) + 1);
+		}
+	}
+};
+
+#endif /* MOVELIST_H_ */
@@ -0,0 +1,26 @@
+/*
+ * Perft.cpp
+ *
+ *  Created on: 16/10/2026
+ */
+
+#include "Perft.h"
+
+unsigned long long perft(State &state, int depth) {
+	if (depth == 0) return 1;
+
+	// a won sub-board ends the game, and so does play sent to a full one
+	if (state.isOver()) return 0;
+	MoveList moves = state.available(state.getCurrSub());
+
+	// every move is a leaf, no need to make them
+	if (depth == 1) return moves.size();
+
+	unsigned long long leaves = 0;
+	for (int move : moves) {
+		state.makeMove(move);
+		leaves += perft(state, depth - 1);
+		state.unmakeMove();
+	}
+	return leaves;
+}
@@ -0,0 +1,25 @@
+/*
+ * Perft.h
+ *
+ * Counts the leaves of the legal game tree below a State to a fixed depth,
+ * using makeMove and unmakeMove, with the rules of game.c's make_move: each
+ * move is made in the sub-board named by the previous move, a move that wins
+ * its sub-board ends the game, and so does a move that sends play to a full
+ * sub-board (a draw). A game that ends before the depth is reached has no
+ * leaves there, but the move ending it is a leaf at the last ply.
+ *
+ * Comparing the counts with ones made another way checks the move generator
+ * and make/unmake; timing them measures their throughput.
+ *
+ *  Created on: 16/10/2026
+ */
+
+#ifndef PERFT_H_
+#define PERFT_H_
+
+#include "State.h"
+
+// the number of legal move sequences depth moves long from state
+unsigned long long perft(State &state, int depth);
+
+#endif /* PERFT_H_ */
@@ -0,0 +1,296 @@
+/*
+ * Server.cpp
+ *
+ *  Created on: 16/10/2026
+ */
+
+#include "Server.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/* the workers' solvers take up to a quarter of the table budget, and the
+ * rest is shared equally between the most games there can be at once, in KB
+ * so that the tables together never take more than it (each table rounds its
+ * share down to a power of two entries) */
+Server::Server(int maxGames, int workers, int hashMB, int moveTime,
+		int startDepth, Configure configure) : maxGames(std::max(1, maxGames)),
+		moveTime(moveTime), startDepth(startDepth), configure(configure) {
+	int budgetKB = std::max(0, hashMB) * 1024;
+	workers = std::max(1, workers);
+	solverKB = std::min(int(Solver::DEFAULT_KB), budgetKB / 4 / workers);
+	hashKB = (budgetKB - workers * solverKB) / this->maxGames;
+	for (int i = 0; i < workers; ++i) {
+		this->workers.emplace_back(&Server::work, this);
+	}
+}
+
+Server::~Server() {
+	{
+		std::lock_guard<std::mutex> lock(readyMutex);
+		stopping = true;
+	}
+	readyCond.notify_all();
+	for (std::thread &w : workers) {
+		w.join();
+	}
+	if (listenFd >= 0) close(listenFd);
+	if (epollFd >= 0) close(epollFd);
+}
+
+Server::Game::~Game() {
+	close(fd);
+}
+
+// listen for connections on port, from any address
+bool Server::listen(int port) {
+	epollFd = epoll_create1(0);
+	if (epollFd < 0) {
+		std::perror("cannot create epoll instance");
+		return false;
+	}
+	listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+	if (listenFd < 0) {
+		std::perror("cannot open socket");
+		return false;
+	}
+	int one = 1;
+	setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+	sockaddr_in addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(port);
+	if (bind(listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0
+			|| ::listen(listenFd, BACKLOG) < 0) {
+		std::perror("cannot listen");
+		return false;
+	}
+	return true;
+}
+
+/* wait for connections and messages. New connections are only accepted while
+ * there are fewer than maxGames games. Returns only if epoll fails. */
+void Server::run() {
+	epoll_event events[MAX_EVENTS];
+	for (;;) {
+		setAccepting(int(games.size()) < maxGames);
+
+		int n = epoll_wait(epollFd, events, MAX_EVENTS, -1);
+		if (n < 0) {
+			if (errno == EINTR) continue;
+			std::perror("epoll_wait");
+			return;
+		}
+
+		for (int i = 0; i != n; ++i) {
+			int fd = events[i].data.fd;
+			if (fd == listenFd) {
+				accept();
+				continue;
+			}
+			// a game forgotten earlier in this batch has nothing to read
+			auto g = games.find(fd);
+			if (g != games.end() && !receive(g->second)) forget(g);
+		}
+	}
+}
+
+// add listenFd to the epoll set, or take it out
+void Server::setAccepting(bool on) {
+	if (on == accepting) return;
+	epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.fd = listenFd;
+	epoll_ctl(epollFd, on ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, listenFd, &ev);
+	accepting = on;
+}
+
+// start a game on a new connection
+void Server::accept() {
+	int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK);
+	if (fd < 0) return;
+	int one = 1;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+	GamePtr g = std::make_shared<Game>(fd, hashKB);
+	configure(g->engine);
+	g->engine.setThreads(1);
+
+	epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.fd = fd;
+	if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) return;
+	games[fd] = g;
+}
+
+/* read what has arrived for a game and pass on each whole message. False if
+ * the connection is closed or sends nonsense. */
+bool Server::receive(const GamePtr &g) {
+	if (!proto_receive(g->fd, &g->input)) return false;
+
+	clock::time_point now = clock::now();
+	Message m;
+	m.received = now;
+	int parsed;
+	while ((parsed = proto_next(&g->input, &m.msg)) == 1) {
+		deliver(g, std::move(m));
+	}
+	return parsed == 0;
+}
+
+/* stop listening to a game's connection. The worker serving it, if any, lets
+ * it go, and its socket is closed when the last reference to it goes. */
+void Server::forget(std::map<int, GamePtr>::iterator g) {
+	epoll_ctl(epollFd, EPOLL_CTL_DEL, g->first, nullptr);
+	{
+		std::lock_guard<std::mutex> lock(g->second->mutex);
+		g->second->closed = true;
+		g->second->inbox.clear();
+	}
+	games.erase(g);
+}
+
+// queue a message for a game, and the game for a worker if it isn't already
+void Server::deliver(const GamePtr &g, Message &&m) {
+	{
+		std::lock_guard<std::mutex> lock(g->mutex);
+		g->inbox.push_back(std::move(m));
+		if (g->scheduled) return;
+		g->scheduled = true;
+	}
+	{
+		std::lock_guard<std::mutex> lock(readyMutex);
+		ready.push_back(g);
+	}
+	readyCond.notify_one();
+}
+
+// a worker thread: serve games with messages waiting until the server stops
+void Server::work() {
+	std::shared_ptr<Solver> solver = std::make_shared<Solver>(solverKB);
+	for (;;) {
+		GamePtr g;
+		{
+			std::unique_lock<std::mutex> lock(readyMutex);
+			readyCond.wait(lock, [this] { return stopping || !ready.empty(); });
+			if (stopping) return;
+			g = std::move(ready.front());
+			ready.pop_front();
+		}
+		g->engine.setSolver(solver);
+		serve(g);
+	}
+}
+
+/* handle a game's next message. If more are waiting the game goes to the
+ * back of the queue again, so that a game whose opponent replies at once
+ * can't keep a worker from the others. */
+void Server::serve(const GamePtr &g) {
+	Message m;
+	{
+		std::lock_guard<std::mutex> lock(g->mutex);
+		if (g->inbox.empty() || g->closed) {
+			g->scheduled = false;
+			return;
+		}
+		m = std::move(g->inbox.front());
+		g->inbox.pop_front();
+	}
+
+	bool more = handle(*g, m);
+	{
+		std::lock_guard<std::mutex> lock(g->mutex);
+		if (!more) {
+			// run sees the connection close and forgets the game
+			g->closed = true;
+			shutdown(g->fd, SHUT_RDWR);
+		}
+		if (g->inbox.empty() || g->closed) {
+			g->scheduled = false;
+			return;
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(readyMutex);
+		ready.push_back(g);
+	}
+	readyCond.notify_one();
+}
+
+/* act on one message as client.c and agent.cpp do, replying to a request for
+ * a move. False at the end of the series, or on a move off the board. */
+bool Server::handle(Game &g, const Message &m) {
+	GameEngine &ge = g.engine;
+	const proto_msg &msg = m.msg;
+	int args = 0;
+	switch (msg.type) {
+	case PROTO_SECOND_MOVE: args = 2; break;
+	case PROTO_THIRD_MOVE: args = 3; break;
+	case PROTO_NEXT_MOVE: case PROTO_LAST_MOVE: args = 1; break;
+	}
+	for (int i = 0; i != args; ++i) {
+		if (msg.args[i] < 1 || msg.args[i] > 9) return false;
+	}
+
+	switch (msg.type) {
+	case PROTO_START:
+		ge.reset();
+		ge.setPlayer(msg.player);
+		break;
+	case PROTO_SECOND_MOVE:
+		ge.update(msg.args[0], msg.args[1], ge.getOpponent());
+		ge.setCurrSub(msg.args[1]);
+		search(g, m);
+		break;
+	case PROTO_THIRD_MOVE:
+		ge.update(msg.args[0], msg.args[1], ge.getPlayer());
+		ge.update(msg.args[1], msg.args[2], ge.getOpponent());
+		ge.setCurrSub(msg.args[2]);
+		search(g, m);
+		break;
+	case PROTO_NEXT_MOVE:
+		ge.update(ge.getMove(), msg.args[0], ge.getOpponent());
+		ge.setCurrSub(msg.args[0]);
+		search(g, m);
+		break;
+	case PROTO_LAST_MOVE:
+		ge.update(ge.getMove(), msg.args[0], ge.getOpponent());
+		break;
+	case PROTO_END:
+		return false;
+	}
+	// init, win, loss and draw need nothing
+	return true;
+}
+
+/* search for the move asked for by m and send it. The search gets what is
+ * left of the move time since m arrived, divided between it and the games
+ * waiting for each worker. */
+void Server::search(Game &g, const Message &m) {
+	using std::chrono::duration_cast;
+	using std::chrono::milliseconds;
+
+	std::size_t waiting;
+	{
+		std::lock_guard<std::mutex> lock(readyMutex);
+		waiting = ready.size();
+	}
+	long left = moveTime - duration_cast<milliseconds>(
+			clock::now() - m.received).count();
+	long share = left / long(1 + waiting / workers.size());
+	g.engine.setMoveTime(std::max(1L, share));
+
+	// a failed send shows up as the connection closing
+	proto_send_move(g.fd, g.engine.iterDeepSearch(startDepth));
+}
@@ -0,0 +1,118 @@
+/*
+ * Server.h
+ *
+ * Server mode (agent -l port): instead of connecting to one game server, the
+ * agent listens for connections and plays a game series on each, all at once.
+ * Each connection speaks the same protocol as client.c and has a GameEngine of
+ * its own. The engines share a fixed pool of worker threads and a memory
+ * budget for their tables: each worker has a solver (see Solver.h), used by
+ * whichever game it is serving, and every game gets an equal share of the
+ * rest for its transposition table, so no more than maxGames connections are
+ * accepted at a time and further ones wait in the listen backlog until a game
+ * ends.
+ *
+ * One thread (run) waits on every socket with epoll, receives from each into
+ * a ring buffer of its game without blocking, parses the messages where they
+ * lie (see protocol.h) and hands them to the workers. The messages of a game
+ * are handled in order, one at a time, by whichever worker is free; the games
+ * take turns, and a worker searches on one thread and writes the reply. A
+ * move's time runs from when its message arrived, so time spent waiting for a
+ * free worker comes out of its search, and what is left is shared with the
+ * games waiting behind it, so that the replies to all of them still come
+ * within the move time.
+ *
+ *  Created on: 16/10/2026
+ */
+
+#ifndef SERVER_H_
+#define SERVER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "GameEngine.h"
+#include "protocol.h"
+
+class Server {
+public:
+	// sets up a new game's engine from the command line options
+	typedef std::function<void(GameEngine &)> Configure;
+
+	Server(int maxGames, int workers, int hashMB, int moveTime,
+			int startDepth, Configure configure);
+	~Server();
+	Server(const Server &) = delete;
+	Server &operator=(const Server &) = delete;
+
+	bool listen(int port); // false (with a message) on failure
+	void run(); // serve connections, returns only on an error
+
+	enum { DEFAULT_GAMES = 64 };
+
+private:
+	typedef TimeManager::clock clock;
+
+	// a message as parsed, with the time it was received
+	struct Message {
+		proto_msg msg;
+		clock::time_point received;
+	};
+
+	// a connection and the game series played on it
+	struct Game {
+		Game(int fd, int hashKB) : fd(fd), engine(0) {
+			engine.setHashSizeKB(hashKB);
+			proto_ring_init(&input);
+		}
+		~Game();
+
+		int fd;
+		GameEngine engine; // used only by the worker serving the game
+		proto_ring input; // received but not yet parsed, run only
+
+		std::mutex mutex; // for the rest
+		std::deque<Message> inbox; // messages waiting for a worker
+		bool scheduled = false; // in the ready queue or being served
+		bool closed = false;
+	};
+	typedef std::shared_ptr<Game> GamePtr;
+
+	int maxGames;
+	int solverKB; // each worker's solver table
+	int hashKB; // each game's share of the rest of the budget
+	int moveTime; // ms from a request for a move to the reply
+	int startDepth;
+	Configure configure;
+	int listenFd = -1;
+	int epollFd = -1;
+	bool accepting = false; // listenFd is in the epoll set
+
+	std::map<int, GamePtr> games; // by socket, run only
+
+	// games with messages waiting, for the workers
+	std::mutex readyMutex;
+	std::condition_variable readyCond;
+	std::deque<GamePtr> ready;
+	bool stopping = false;
+	std::vector<std::thread> workers;
+
+	void accept();
+	void setAccepting(bool);
+	bool receive(const GamePtr &);
+	void forget(std::map<int, GamePtr>::iterator);
+	void deliver(const GamePtr &, Message &&);
+	void work();
+	void serve(const GamePtr &);
+	bool handle(Game &, const Message &);
+	void search(Game &, const Message &);
+
+	enum { BACKLOG = 128, MAX_EVENTS = 64 };
+};
+
+#endif /* SERVER_H_ */
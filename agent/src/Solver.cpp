@@ -0,0 +1,208 @@
+/*
+ * Solver.cpp
+ *
+ *  Created on: 16/10/2026
+ */
+
+#include "Solver.h"
+
+namespace {
+
+// the lines of a sub-board as masks of positions, bit pos - 1 for pos
+const unsigned LINES[8] = {
+	0007, 0070, 0700, // rows
+	0111, 0222, 0444, // columns
+	0421, 0124 // diagonals
+};
+
+/* for each mask of a player's marks on a sub-board, the squares which would
+ * complete a line */
+struct ThreatTable {
+	unsigned short threats[512];
+
+	ThreatTable() {
+		for (unsigned m = 0; m != 512; ++m) {
+			threats[m] = 0;
+			for (unsigned line : LINES) {
+				unsigned missing = line & ~m;
+				// exactly one square of the line missing
+				if (missing != 0 && (missing & (missing - 1)) == 0) {
+					threats[m] |= missing;
+				}
+			}
+		}
+	}
+};
+
+const ThreatTable &threatTable() {
+	static const ThreatTable table;
+	return table;
+}
+
+unsigned threats(unsigned mask) {
+	return threatTable().threats[mask];
+}
+
+// Zobrist keys for the solver's table, see State.cpp
+struct SolverKeys {
+	std::uint64_t mark[2][9][9];
+	std::uint64_t sub[9];
+	std::uint64_t side;
+
+	SolverKeys() {
+		std::uint64_t seed = 0x243f6a8885a308d3ull;
+		for (auto &side : mark) {
+			for (auto &sub : side) {
+				for (std::uint64_t &k : sub) k = next(seed);
+			}
+		}
+		for (std::uint64_t &k : sub) k = next(seed);
+		side = next(seed);
+	}
+
+	// splitmix64
+	static std::uint64_t next(std::uint64_t &seed) {
+		std::uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		return z ^ (z >> 31);
+	}
+};
+
+const SolverKeys &keys() {
+	static const SolverKeys k;
+	return k;
+}
+
+}
+
+// the largest power of two entries that fits in kb, at least one
+Solver::Solver(std::size_t kb) {
+	std::size_t count = 1;
+	while (count * 2 * sizeof(Entry) <= (kb << 10)) count *= 2;
+	table.assign(count, Entry());
+	mask = count - 1;
+}
+
+int Solver::solve(const State &state, int &move, time_point deadline) {
+	move = 0;
+	if (state.isDecided()) return UNKNOWN;
+
+	key = 0;
+	for (int side = 0; side != 2; ++side) {
+		for (int sub = 0; sub != 9; ++sub) {
+			marks[side][sub] = state.markMask(sub + 1,
+					side == 0 ? SubBoard::X_MARK : SubBoard::O_MARK);
+			for (unsigned m = marks[side][sub]; m != 0; m &= m - 1) {
+				key ^= keys().mark[side][sub][__builtin_ctz(m)];
+			}
+		}
+	}
+
+	nodes = 0;
+	aborted = false;
+	this->deadline = deadline;
+	int side = (state.getCurrPlayer() == SubBoard::X_MARK) ? 0 : 1;
+	int sub = state.getCurrSub() - 1;
+	if (empty(sub) == 0) return UNKNOWN;
+
+	int value = search(side, sub, LOSS, WIN);
+	if (aborted) return UNKNOWN;
+
+	// the root is the last position stored
+	const Entry &e = table[(key ^ keys().sub[sub] ^ (side ? keys().side : 0))
+			& mask];
+	move = e.move + 1;
+	return value;
+}
+
+// add (or remove) a mark for side at pos (0 to 8) of sub-board sub (0 to 8)
+void Solver::play(int side, int sub, int pos) {
+	marks[side][sub] ^= 1u << pos;
+	key ^= keys().mark[side][sub][pos];
+}
+
+/* negamax alpha-beta search of the rest of the game, side to play on sub,
+ * returning WIN, DRAW or LOSS for side */
+int Solver::search(int side, int sub, int alpha, int beta) {
+	if ((++nodes & (POLL_NODES - 1)) == 0 &&
+			std::chrono::steady_clock::now() >= deadline) {
+		aborted = true;
+	}
+	if (aborted) return DRAW;
+
+	std::uint64_t k = key ^ keys().sub[sub] ^ (side ? keys().side : 0);
+	Entry &e = table[k & mask];
+	unsigned free = empty(sub);
+
+	// a square completing a line wins at once
+	unsigned wins = threats(marks[side][sub]) & free;
+	if (wins != 0) {
+		e = Entry{k, WIN, EXACT,
+			static_cast<unsigned char>(__builtin_ctz(wins))};
+		return WIN;
+	}
+
+	int hashMove = -1;
+	if (e.key == k && e.type != NO_VALUE) {
+		if (e.type == EXACT) return e.value;
+		if (e.type == LOWER_BOUND && e.value >= beta) return e.value;
+		if (e.type == UPPER_BOUND && e.value <= alpha) return e.value;
+		hashMove = e.move;
+	}
+
+	/* moves which end the game are scored without making them: one sending
+	 * the opponent to a full sub-board draws, and one sending them to where
+	 * they can complete a line loses. The rest are searched, the hash move
+	 * first. */
+	int alphaOrig = alpha;
+	int best = LOSS - 1;
+	int bestMove = 0;
+	unsigned searchMoves = 0;
+	for (unsigned m = free; m != 0; m &= m - 1) {
+		int pos = __builtin_ctz(m);
+		unsigned targetFree = empty(pos) & ~(pos == sub ? 1u << pos : 0);
+		int v;
+		if (targetFree == 0) v = DRAW;
+		else if (threats(marks[side ^ 1][pos]) & targetFree) v = LOSS;
+		else {
+			searchMoves |= 1u << pos;
+			continue;
+		}
+		if (v > best) {
+			best = v;
+			bestMove = pos;
+		}
+	}
+	if (best > alpha) alpha = best;
+
+	if (alpha < beta && hashMove >= 0 && (searchMoves >> hashMove & 1)) {
+		searchMoves &= ~(1u << hashMove);
+		searchMoves = (searchMoves << 9) | (1u << hashMove);
+	}
+	else {
+		searchMoves <<= 9;
+	}
+
+	// the hash move, if any, is in the low 9 bits and the rest above
+	for (unsigned m = searchMoves; m != 0 && alpha < beta; m &= m - 1) {
+		int pos = __builtin_ctz(m) % 9;
+		play(side, sub, pos);
+		int v = -search(side ^ 1, pos, -beta, -alpha);
+		play(side, sub, pos);
+		if (aborted) return DRAW;
+
+		if (v > best) {
+			best = v;
+			bestMove = pos;
+		}
+		if (best > alpha) alpha = best;
+	}
+
+	int type = EXACT;
+	if (best <= alphaOrig) type = UPPER_BOUND;
+	else if (best >= beta) type = LOWER_BOUND;
+	e = Entry{k, static_cast<signed char>(best),
+		static_cast<unsigned char>(type), static_cast<unsigned char>(bestMove)};
+	return best;
+}
@@ -0,0 +1,79 @@
+/*
+ * Solver.h
+ *
+ * Exact solver for positions near the end of the game. Where the ordinary
+ * search stops at a depth cutoff and scores the frontier with the heuristic,
+ * the solver searches to the end of the game and knows only win, draw and
+ * loss, so the alpha-beta window is never wider than one and most of the tree
+ * is cut off.
+ *
+ * The position is held as a bitboard: a 9 bit mask of each player's marks on
+ * each sub-board. A sub-board is won when a player's mask covers a line, and
+ * a table of the squares which would complete a line for each of the 512
+ * masks finds an immediate win (or a move which hands the opponent one)
+ * without making the move. Results are kept in a small transposition table
+ * of its own, always replacing.
+ *
+ *  Created on: 16/10/2026
+ */
+
+#ifndef SOLVER_H_
+#define SOLVER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "State.h"
+
+class Solver {
+public:
+	typedef std::chrono::steady_clock::time_point time_point;
+
+	// a table of at most kb KB
+	explicit Solver(std::size_t kb = DEFAULT_KB);
+
+	/* the result for the player to move in state, playing on its current
+	 * sub-board, and a move achieving it. UNKNOWN if the deadline passes
+	 * first. */
+	int solve(const State &state, int &move, time_point deadline);
+	unsigned long getNodes() const { return nodes; }
+
+	enum { LOSS = -1, DRAW = 0, WIN = 1, UNKNOWN = 2 };
+	enum { DEFAULT_KB = 1024 };
+
+private:
+	struct Entry {
+		std::uint64_t key;
+		signed char value;
+		unsigned char type;
+		unsigned char move;
+	};
+
+	enum { NO_VALUE, EXACT, UPPER_BOUND, LOWER_BOUND };
+
+	// check the clock every POLL_NODES nodes, a power of 2
+	enum { POLL_NODES = 4096 };
+
+	std::vector<Entry> table;
+	std::size_t mask; // table size - 1
+
+	/* mark masks of each side (X then O) on each sub-board, and a Zobrist key
+	 * of the marks only; the sub-board and side to move are added to it when
+	 * the table is used */
+	unsigned marks[2][9];
+	std::uint64_t key = 0;
+
+	unsigned long nodes = 0;
+	time_point deadline;
+	bool aborted = false;
+
+	int search(int side, int sub, int alpha, int beta);
+	void play(int side, int sub, int pos);
+	unsigned empty(int sub) const {
+		return ~(marks[0][sub] | marks[1][sub]) & 0x1FF;
+	}
+};
+
+#endif /* SOLVER_H_ */
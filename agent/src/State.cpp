@@ -8,12 +8,68 @@
 #include "State.h"
 #include "SubBoard.h"
 
+namespace {
+
+/* Zobrist keys: one random 64 bit number for each mark on each square, each
+ * sub-board of play and each player. The key of a state is the exclusive-or of
+ * the numbers for everything in it, so a move changes it with a few XORs. A
+ * fixed seed keeps keys the same from run to run.
+ */
+struct Zobrist {
+	std::uint64_t mark[9][9][3]; // blank squares have a zero key
+	std::uint64_t sub[10]; // sub-board 0 is "not yet set"
+	std::uint64_t player[3];
+
+	Zobrist() {
+		std::uint64_t seed = 0x9e3779b97f4a7c15ull;
+		for (int b = 0; b != 9; ++b) {
+			for (int p = 0; p != 9; ++p) {
+				mark[b][p][SubBoard::BLANK] = 0;
+				mark[b][p][SubBoard::X_MARK] = next(seed);
+				mark[b][p][SubBoard::O_MARK] = next(seed);
+			}
+		}
+		for (int i = 0; i != 10; ++i) sub[i] = next(seed);
+		for (int i = 0; i != 3; ++i) player[i] = next(seed);
+	}
+
+	// splitmix64 generator
+	static std::uint64_t next(std::uint64_t &seed) {
+		std::uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		return z ^ (z >> 31);
+	}
+};
+
+// built on first use, as States may be constructed during static initialisation
+const Zobrist &zobrist() {
+	static const Zobrist keys;
+	return keys;
+}
+
+}
+
 /* set a square on sub-board board at position pos to X or O. Safe only if the
  * square is blank. Use the enums SubBoard::X_MARK, SubBoard::O_MARK and
  * SubBoard::BLANK to pass values */
 void State::update(int board, int pos, int val) {
+	int before = state[board - 1].evaluate();
 	state[board - 1].update(pos,val);
-	evaluated = false;
+	key ^= zobrist().mark[board - 1][pos - 1][val];
+	rescore(before, state[board - 1].evaluate());
+}
+
+// set the sub-board of play
+void State::setCurrSub(int s) {
+	key ^= zobrist().sub[currSub] ^ zobrist().sub[s];
+	currSub = s;
+}
+
+// set the player to move
+void State::setCurrPlayer(int p) {
+	key ^= zobrist().player[currPlayer] ^ zobrist().player[p];
+	currPlayer = p;
 }
 
 // returns the value of a square on sub-board board, position pos
@@ -27,77 +83,78 @@ void State::clear() {
 		state[i].clear();
 	}
 	util = 0;
+	result = 0;
 	currSub = 0;
 	currPlayer = 0;
-	evaluated = false;
-	value = 0;
-	value_type = NO_VALUE;
-	relDepth = 0;
-}
-
-// return a vector of blank positions in sub-board board.
-std::vector<int> State::available(int board) const {
-	return state[board - 1].available();
+	numMoves = 0;
+	key = zobrist().sub[0] ^ zobrist().player[0];
 }
 
-// return the utility of this state, given player
+/* return the utility of this state, given player. A win or loss is adjusted
+ * by depth so that quicker wins (and slower losses) are preferred; the search
+ * passes the number of moves made in the game, so the value of a state does
+ * not depend on where the search started. A drawn game is worth 0. */
 int State::utility(int player, int depth) const {
-	if (evaluated == false) {
-		evaluate();
-		evaluated = true;
-	}
-
 	int retval = 0;
+	if (isDrawn()) return 0;
 	if (player == SubBoard::X_MARK) {
-		if (util == SubBoard::WIN) retval = util - depth;
-		else if (util == SubBoard::LOSS) retval = util + depth;
+		if (result == SubBoard::WIN) retval = result - depth;
+		else if (result == SubBoard::LOSS) retval = result + depth;
 		else retval = util;
 	}
 	else {
-		if (util == SubBoard::WIN) retval = -(util - depth);
-		else if (util == SubBoard::LOSS) retval = -(util + depth);
+		if (result == SubBoard::WIN) retval = -(result - depth);
+		else if (result == SubBoard::LOSS) retval = -(result + depth);
 		else retval = -util;
 	}
 
 	return retval;
 }
 
-// calculate and store the utility of this state
-void State::evaluate() const {
-	util = 0;
-	// sum the utilities of the sub-boards, or assign WIN or LOSS
-	for (int i = 0; i != 9; ++i) {
-		int subBoardEval = state[i].evaluate();
-		if (subBoardEval == SubBoard::WIN || subBoardEval == SubBoard::LOSS) {
-			util = subBoardEval;
-			return;
-		}
-		util += subBoardEval;
-	}
+/* keep the utility up to date when one sub-board changes from evaluation
+ * before to after. A won sub-board decides the game, so its evaluation is
+ * recorded as the result rather than added to the sum. */
+void State::rescore(int before, int after) {
+	if (before == SubBoard::WIN || before == SubBoard::LOSS) result = 0;
+	else util -= before;
+
+	if (after == SubBoard::WIN || after == SubBoard::LOSS) result = after;
+	else util += after;
 }
 
 // update the state given a move
 void State::makeMove(int pos) {
 	// update the sub-board with the required move
 	update(currSub, pos, currPlayer);
+	prevSub[numMoves++] = currSub;
 	// set the new sub-board of play
-	currSub = pos;
+	setCurrSub(pos);
 	// swap players
-	currPlayer = (currPlayer == SubBoard::X_MARK) ? SubBoard::O_MARK
-					: SubBoard::X_MARK;
+	setCurrPlayer((currPlayer == SubBoard::X_MARK) ? SubBoard::O_MARK
+					: SubBoard::X_MARK);
 }
 
-// define equality and inequality operators for State class
-bool operator==(const State &a, const State &b) {
-	/* a state is equal if all sub-boards are equal, the active sub-boards
-	 * are equal and the active players are equal */
-	for (int i = 0; i != 9; ++i) {
-		if (a.state[i].getBoard() != b.state[i].getBoard()) return false;
-	}
-	if (a.currSub != b.currSub) return false;
-	if (a.currPlayer != b.currPlayer) return false;
+// take back the last move made with makeMove
+void State::unmakeMove() {
+	int pos = currSub;
+	int board = prevSub[--numMoves];
+
+	// the player who made the move is to play again, on the previous sub-board
+	setCurrPlayer((currPlayer == SubBoard::X_MARK) ? SubBoard::O_MARK
+					: SubBoard::X_MARK);
+	setCurrSub(board);
 
-	return true;
+	int before = state[board - 1].evaluate();
+	state[board - 1].remove(pos);
+	key ^= zobrist().mark[board - 1][pos - 1][currPlayer];
+	rescore(before, state[board - 1].evaluate());
+}
+
+/* define equality and inequality operators for State class. A state is equal
+ * if all sub-boards, the active sub-boards and the active players are equal,
+ * all of which is summarised by the Zobrist key. */
+bool operator==(const State &a, const State &b) {
+	return a.key == b.key;
 }
 
 bool operator!=(const State &a, const State &b) {
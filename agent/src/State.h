@@ -8,9 +8,13 @@
 #ifndef STATE_H_
 #define STATE_H_
 
-#include <vector>
+#include <cstdint>
 #include "SubBoard.h"
 
+/* The whole state is held inline (no heap storage) so that copying one is
+ * cheap, although the search works on a single State using makeMove and
+ * unmakeMove rather than copying.
+ */
 class State {
 	friend std::ostream &operator<<(std::ostream&, const State&);
 	friend std::hash<State>;
@@ -18,41 +22,60 @@ class State {
 	friend bool operator!=(const State &, const State &);
 
 public:
-	State() : state(9) { }
+	State() { clear(); }
 	void update(int board, int pos, int val);
 	int query(int board, int pos);
 	void clear();
-	std::vector<int> available (int board) const;
+	MoveList available(int board) const { return state[board - 1].available(); }
+	unsigned markMask(int board, int val) const {
+		return state[board - 1].markMask(val);
+	}
 	int utility(int player, int depth) const;
 
+	// see SubBoard::winCells and SubBoard::isFull
+	unsigned winCells(int board, int val) const {
+		return state[board - 1].winCells(val);
+	}
+	bool isFull(int board) const { return state[board - 1].isFull(); }
+
+	// see SubBoard::evaluate and SubBoard::evaluateMoves
+	int evaluate(int board) const { return state[board - 1].evaluate(); }
+	void evaluateMoves(int board, int val, int values[9]) const {
+		state[board - 1].evaluateMoves(val, values);
+	}
+
 	int getCurrSub() const { return currSub; }
 	int getCurrPlayer() const { return currPlayer; }
-	int getValue() const { return value; }
-	int getValueType() const { return value_type; }
-	int getRelDepth() const { return relDepth; }
+	std::uint64_t getKey() const { return key; }
+	int getNumMoves() const { return numMoves; }
+	bool isDecided() const { return result != 0; }
+	/* as game.c has it, a move that doesn't win but sends play to a full
+	 * sub-board draws the game */
+	bool isDrawn() const {
+		return result == 0 && currSub != 0 && isFull(currSub);
+	}
+	bool isOver() const { return isDecided() || isDrawn(); }
 
-	void setCurrSub(int s) { currSub = s; }
-	void setCurrPlayer(int p) { currPlayer = p; }
-	void setValue(int v) const { value = v; }
-	void setValueType(int vt) const { value_type = vt; }
-	void setRelDepth(int d) const { relDepth = d; }
+	void setCurrSub(int s);
+	void setCurrPlayer(int p);
 
 	void makeMove(int);
+	void unmakeMove();
 
-	enum {NO_VALUE, EXACT, UPPER_BOUND, LOWER_BOUND}; // value types for t-table
+	enum { MAX_MOVES = 81 };
 
 private:
-	std::vector<SubBoard> state;
+	SubBoard state[9];
 	int currSub = 0; // current sub-board of play
-	mutable int util = 0; // record the utility of this state
+	int util = 0; // sum of the utilities of the undecided sub-boards
+	int result = 0; // WIN or LOSS once a sub-board is won, 0 otherwise
 	int currPlayer = 0; // current player for this state
-	mutable bool evaluated = false;
-	void evaluate() const;
+	std::uint64_t key = 0; // Zobrist key, kept up to date by every change
 
-	// transposition table variables
-	mutable int value = 0;
-	mutable int value_type = NO_VALUE; // see public enum above for types
-	mutable int relDepth = 0; // height of node above depth cutoff
+	// sub-board of play before each move, for unmakeMove
+	unsigned char prevSub[MAX_MOVES];
+	int numMoves = 0;
+	void rescore(int before, int after);
 };
 
 // declare non-member functions
@@ -60,26 +83,14 @@ std::ostream &operator<<(std::ostream&, const State&);
 bool operator==(const State &, const State &);
 bool operator!=(const State &, const State &);
 
-// hash_combine borrowed from Boost library; using just EOR gave collisions
-inline void hash_combine(size_t &seed, int v) {
-	seed ^= std::hash<int>()(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-}
-
 /* Specialise the hash function; a state is uniquely identified by the board,
- * the current sub-board of play and the current player. Other variables, such
- * as those used by the transposition table, are not identifiers of a unique
- * state and are expressly not included.
+ * the current sub-board of play and the current player, all of which are
+ * folded into the Zobrist key as they change.
  */
 namespace std {
 template <> struct hash<State> {
 	std::size_t operator()(State const& s) const {
-		std::size_t h = 0;
-		for (int i = 0; i != 9; ++i) {
-			hash_combine(h, s.state[i].getBoard());
-		}
-		hash_combine(h, s.currSub);
-		hash_combine(h, s.currPlayer);
-		return h;
+		return s.key;
 	}
 };
 }
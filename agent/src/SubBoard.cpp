@@ -7,6 +7,105 @@
 
 #include "SubBoard.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_AVX2_PATH 1
+#else
+#define HAVE_AVX2_PATH 0
+#endif
+
+short SubBoard::evalTable[SubBoard::TABLE_SIZE + 1];
+unsigned SubBoard::threatTable[SubBoard::TABLE_SIZE];
+const SubBoard::EvaluateMovesFn SubBoard::evaluateMovesFn =
+		SubBoard::chooseEvaluateMoves();
+
+namespace {
+
+// the lines of a sub-board as masks of positions, bit pos - 1 for pos
+const unsigned LINES[8] = {
+	0007, 0070, 0700, // rows
+	0111, 0222, 0444, // columns
+	0421, 0124 // diagonals
+};
+
+// the blank positions which would complete a line of marks
+unsigned completing(unsigned marks, unsigned blank) {
+	unsigned cells = 0;
+	for (unsigned line : LINES) {
+		unsigned missing = line & ~marks;
+		// exactly one position of the line missing, and it blank
+		if ((missing & (missing - 1)) == 0) cells |= missing & blank;
+	}
+	return cells;
+}
+
+const bool evalTableBuilt = SubBoard::buildEvalTable();
+}
+
+/* fill the evaluation and threat tables. Only the 3^9 boards that can occur
+ * are calculated, by counting in base 3 over the nine positions. */
+bool SubBoard::buildEvalTable() {
+	SubBoard board;
+	int digits[9] = {0};
+	for (int n = 0; n != 19683; ++n) {
+		board.the_board = 0;
+		for (int pos = 1; pos != 10; ++pos) {
+			board.update(pos, digits[pos - 1]);
+		}
+		evalTable[board.the_board] = board.evaluateDirect();
+
+		unsigned blank = board.emptyMask();
+		threatTable[board.the_board] =
+				completing(board.markMask(X_MARK), blank) |
+				completing(board.markMask(O_MARK), blank) << THREAT_O_SHIFT |
+				(blank == 0 ? THREAT_FULL : 0);
+
+		// next base 3 number
+		for (int i = 0; i != 9 && ++digits[i] == 3; ++i) {
+			digits[i] = 0;
+		}
+	}
+	return true;
+}
+
+SubBoard::EvaluateMovesFn SubBoard::chooseEvaluateMoves() {
+#if HAVE_AVX2_PATH
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) return evaluateMovesAVX2;
+#endif
+	return evaluateMovesScalar;
+}
+
+// one table lookup per position
+void SubBoard::evaluateMovesScalar(unsigned long board, int val, int *values) {
+	for (int pos = 1; pos != 10; ++pos) {
+		values[pos - 1] = evalTable[board | (unsigned long)val << 2 * (pos - 1)];
+	}
+}
+
+#if HAVE_AVX2_PATH
+/* positions 1 to 8 in one gather from the table, position 9 on its own. Each
+ * lane reads 32 bits at its entry and keeps the low 16, the entry itself.
+ * Occupied positions can index up to the last entry, so the table has one
+ * spare after it for the upper half of that read. */
+__attribute__((target("avx2")))
+void SubBoard::evaluateMovesAVX2(unsigned long board, int val, int *values) {
+	const __m256i shifts = _mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14);
+	__m256i index = _mm256_or_si256(_mm256_set1_epi32(board),
+			_mm256_sllv_epi32(_mm256_set1_epi32(val), shifts));
+	__m256i entries = _mm256_i32gather_epi32(
+			reinterpret_cast<const int *>(evalTable), index, 2);
+	// sign extend the low 16 bits of each lane
+	entries = _mm256_srai_epi32(_mm256_slli_epi32(entries, 16), 16);
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(values), entries);
+	values[8] = evalTable[board | (unsigned long)val << 16];
+}
+#else
+void SubBoard::evaluateMovesAVX2(unsigned long board, int val, int *values) {
+	evaluateMovesScalar(board, val, values);
+}
+#endif
+
 /* insert an X or an O into position pos (NB safe only if pos is blank). We
  * only ever need to add X or O, never remove or change them, so we can use
  * bitwise OR here.
@@ -17,6 +116,12 @@ void SubBoard::update(const int pos, const int val) {
 	the_board = the_board | bitVal;
 }
 
+// blank position pos again, undoing an update
+void SubBoard::remove(const int pos) {
+	unsigned long int mask = 3;
+	the_board = the_board & ~(mask << 2 * (pos - 1));
+}
+
 // clear the subboard
 void SubBoard::clear() {
 	the_board = 0;
@@ -35,20 +140,9 @@ bool SubBoard::poscheck(const int pos, const int val) {
 	return query(pos) == val;
 }
 
-// return all the available (blank) positions as a vector of position numbers
-std::vector<int> SubBoard::available() const {
-	long unsigned int copy = the_board;
-	long unsigned int mask = 3;
-	std::vector<int> result;
-	for (int i = 1; i != 10; ++i) {
-		if ((copy & mask) == 0) result.push_back(i);
-		copy = copy >> 2;
-	}
-	return result;
-}
-
-// return the utility of this board state, assuming player is X
-int SubBoard::evaluate() const {
+/* return the utility of this board state, assuming player is X. evaluate()
+ * looks the result up in a table built with this function. */
+int SubBoard::evaluateDirect() const {
 	// determine if win or loss
 	// check rows
 	unsigned long int masked = the_board & MASK_ROW_1;
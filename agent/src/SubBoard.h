@@ -10,7 +10,8 @@
  *      Author: Laughlin Dawes 3106483
  */
 #include <iostream>
-#include <vector>
+
+#include "MoveList.h"
 
 #ifndef SUBBOARD_H_
 #define SUBBOARD_H_
@@ -20,19 +21,52 @@ friend std::ostream &operator<<(std::ostream&, const SubBoard&);
 
 public:
 	void update(const int pos, const int val);
+	void remove(const int pos);
 	int query(const int pos);
 	bool poscheck(const int pos, const int val);
 	void clear();
-	std::vector<int> available() const;
-	int evaluate() const;
+	MoveList available() const { return MoveList(emptyMask()); }
+	unsigned emptyMask() const;
+	unsigned markMask(int val) const;
+	int evaluate() const { return evalTable[the_board]; }
+	unsigned winCells(int val) const;
+	bool isFull() const { return threatTable[the_board] & THREAT_FULL; }
+	int evaluateDirect() const;
+	void evaluateMoves(int val, int values[9]) const;
 	unsigned long getBoard() const { return the_board; }
 
 	enum { BLANK = 0, X_MARK = 1, O_MARK = 2 };
 	enum { WIN = 1000, LOSS = -1000 };
 
+	static bool buildEvalTable();
+
+	/* the two versions of evaluateMoves for a board word, public for
+	 * eval_bench. evaluateMovesAVX2 needs a processor with AVX2. */
+	static void evaluateMovesScalar(unsigned long board, int val, int *values);
+	static void evaluateMovesAVX2(unsigned long board, int val, int *values);
+
 private:
 	unsigned long int the_board = 0; //guaranteed to be at least 32 bit
 
+	/* evaluateDirect() of every board, indexed by the 18 bit board. Filled
+	 * before main() runs, so evaluate() must not be used in static
+	 * initialisers. */
+	enum { TABLE_SIZE = 1 << 18 };
+	static short evalTable[TABLE_SIZE + 1]; // + 1 for the 32 bit gathers
+
+	/* for every board, also indexed by the 18 bit board and filled with
+	 * evalTable: the blank positions where X would complete a line in the
+	 * low 9 bits, those where O would in the next 9, and THREAT_FULL if
+	 * there are no blank positions */
+	enum { THREAT_O_SHIFT = 9, THREAT_FULL = 1 << 18 };
+	static unsigned threatTable[TABLE_SIZE];
+
+	/* evaluateMoves for a board word, chosen when the program starts: the
+	 * AVX2 version if the processor has it, otherwise the scalar one */
+	typedef void (*EvaluateMovesFn)(unsigned long, int, int *);
+	static const EvaluateMovesFn evaluateMovesFn;
+	static EvaluateMovesFn chooseEvaluateMoves();
+
 	// predetermined masks for rows, columns and diagonals
 	enum { MASK_ROW_1 = 0x3F, MASK_ROW_2 = 0xFC0, MASK_ROW_3 = 0x3F000,
 		MASK_COL_1 = 0x30C3, MASK_COL_2 = 0xC30C, MASK_COL_3 = 0x30C30,
@@ -44,6 +78,9 @@ private:
 		TRIPLET_DIAG_DOWN_X = 0x10101, TRIPLET_DIAG_DOWN_O = 0x20202,
 		TRIPLET_DIAG_UP_X = 0x1110, TRIPLET_DIAG_UP_O = 0x2220 };
 
+	// one bit in each position's pair of bits, see emptyMask
+	enum { MASK_LOW_BITS = 0x15555 };
+
 	// values of doublets and singlets - a bit of experimenting here
 	enum { DOUBLET_VAL = 10, SINGLET_VAL = 1 };
 
@@ -52,6 +89,44 @@ private:
 	int diagUt() const;
 	int rowUtCalc(long unsigned int) const;
 	int colUtCalc(long unsigned int) const;
+	static unsigned packLowBits(unsigned long);
 };
 
+/* pack the low bit of each position's pair of bits into a 9 bit mask, with
+ * bit pos - 1 for position pos, by halving the gaps between them each step */
+inline unsigned SubBoard::packLowBits(unsigned long x) {
+	x &= MASK_LOW_BITS;
+	x = (x | x >> 1) & 0x33333;
+	x = (x | x >> 2) & 0x0F0F0F;
+	x = (x | x >> 4) & 0xFF00FF;
+	return (x | x >> 8) & 0x1FF;
+}
+
+/* a 9 bit mask with bit pos - 1 set for each blank position pos. A position
+ * is blank if neither of its two bits is. */
+inline unsigned SubBoard::emptyMask() const {
+	return packLowBits(~(the_board | the_board >> 1));
+}
+
+/* a 9 bit mask of the blank positions where val (X_MARK or O_MARK) would
+ * complete a line and so win the game, bit pos - 1 for position pos */
+inline unsigned SubBoard::winCells(int val) const {
+	unsigned t = threatTable[the_board];
+	return (val == X_MARK ? t : t >> THREAT_O_SHIFT) & 0x1FF;
+}
+
+// a 9 bit mask of the positions holding val (X_MARK or O_MARK)
+inline unsigned SubBoard::markMask(int val) const {
+	unsigned long low = (val == X_MARK) ? the_board : the_board >> 1;
+	unsigned long high = (val == X_MARK) ? the_board >> 1 : the_board;
+	return packLowBits(low & ~high);
+}
+
+/* the evaluate() of this board with val (X_MARK or O_MARK) played at each
+ * position, in values[pos - 1], all at once. Only those of blank positions
+ * mean anything. */
+inline void SubBoard::evaluateMoves(int val, int values[9]) const {
+	evaluateMovesFn(the_board, val, values);
+}
+
 #endif /* SUBBOARD_H_ */
@@ -0,0 +1,117 @@
+/*
+ * TTable.cpp
+ *
+ *  Created on: 16/10/2026
+ */
+
+#include "TTable.h"
+
+#include <algorithm>
+#include <limits>
+
+/* allocate the table, rounding down to a power of two number of buckets (but
+ * at least one) */
+void TTable::resizeKB(std::size_t kb) {
+	count = 1;
+	while (count * 2 * sizeof(Bucket) <= (kb << 10)) count *= 2;
+
+	storage.reset(new Bucket[count + 1]);
+	std::uintptr_t base = reinterpret_cast<std::uintptr_t>(storage.get());
+	base = (base + CACHE_LINE - 1) & ~std::uintptr_t(CACHE_LINE - 1);
+	buckets = reinterpret_cast<Bucket *>(base);
+	mask = count - 1;
+	sizeKB = kb;
+	clear();
+}
+
+// empty every record without releasing memory, not safe during search
+void TTable::clear() {
+	for (std::size_t i = 0; i != count; ++i) {
+		for (Entry &e : buckets[i].entry) {
+			e.key.store(0, std::memory_order_relaxed);
+			e.data.store(0, std::memory_order_relaxed);
+		}
+	}
+}
+
+/* look up the state with the given key, filling in rec and returning true if
+ * it is found */
+bool TTable::probe(std::uint64_t key, Record &rec) const {
+	const Bucket &bucket = buckets[key & mask];
+	for (const Entry &e : bucket.entry) {
+		std::uint64_t data = e.data.load(std::memory_order_relaxed);
+		if ((e.key.load(std::memory_order_relaxed) ^ data) == key
+				&& typeOf(data) != NO_VALUE) {
+			rec.value = static_cast<std::int16_t>(data & 0xFFFF);
+			rec.relDepth = depthOf(data);
+			rec.valueType = typeOf(data);
+			rec.move = (data >> 32) & 0xFF;
+			return true;
+		}
+	}
+	return false;
+}
+
+/* record a result. An existing record for the state is overwritten unless it
+ * came from a deeper search in this generation and the new value is only a
+ * bound. Otherwise the depth-preferred record with the least depth, less an
+ * allowance for age, is replaced if it is stale or the new result is at least
+ * as deep, and failing that the always-replace record is used. Returns true
+ * if the record of another state was overwritten.
+ */
+bool TTable::store(std::uint64_t key, int value, int valueType, int relDepth,
+		int move) {
+	Bucket &bucket = buckets[key & mask];
+	Entry *replace = nullptr;
+
+	for (Entry &e : bucket.entry) {
+		std::uint64_t data = e.data.load(std::memory_order_relaxed);
+		if ((e.key.load(std::memory_order_relaxed) ^ data) == key) {
+			if (relDepth < depthOf(data) && valueType != EXACT &&
+					ageOf(data) == 0) return false;
+			replace = &e;
+			break;
+		}
+	}
+
+	if (replace == nullptr) {
+		Entry *victim = nullptr;
+		int victimDepth = 0, victimAge = 0, victimWorth = 0;
+		for (int i = 0; i != DEPTH_SLOTS; ++i) {
+			std::uint64_t data = bucket.entry[i].data.load(
+					std::memory_order_relaxed);
+			int worth = depthOf(data) - AGE_WEIGHT * ageOf(data);
+			if (victim == nullptr || worth < victimWorth) {
+				victim = &bucket.entry[i];
+				victimDepth = depthOf(data);
+				victimAge = ageOf(data);
+				victimWorth = worth;
+			}
+		}
+		if (victimAge > 0 || relDepth >= victimDepth) replace = victim;
+		else replace = &bucket.entry[BUCKET_SIZE - 1];
+	}
+
+	std::uint64_t old = replace->data.load(std::memory_order_relaxed);
+	bool overwrite = typeOf(old) != NO_VALUE &&
+			(replace->key.load(std::memory_order_relaxed) ^ old) != key;
+
+	std::uint64_t data = pack(value, valueType, relDepth, move);
+	replace->key.store(key ^ data, std::memory_order_relaxed);
+	replace->data.store(data, std::memory_order_relaxed);
+	return overwrite;
+}
+
+std::uint64_t TTable::pack(int value, int valueType, int relDepth,
+		int move) const {
+	// search values can be +/- infinity, clamp them to fit in 16 bits
+	const int limit = std::numeric_limits<std::int16_t>::max();
+	value = std::max(-limit, std::min(limit, value));
+	relDepth = std::max(0, std::min(int(MAX_DEPTH), relDepth));
+
+	return std::uint64_t(std::uint16_t(value))
+			| std::uint64_t(relDepth) << 16
+			| std::uint64_t(valueType) << 24
+			| std::uint64_t(move & 0xFF) << 32
+			| std::uint64_t(generation) << 40;
+}
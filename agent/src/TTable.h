@@ -0,0 +1,84 @@
+/*
+ * TTable.h
+ *
+ * A fixed size transposition table. The table is allocated once, in buckets of
+ * four 16 byte records so that each bucket fills exactly one cache line, and
+ * never grows during search. A record holds only the 64 bit key of the state
+ * (used to verify a hit) and a packed word with the value, value type, height
+ * of the node above the depth cutoff, the best move found and the generation
+ * (search number) that wrote it. The table lasts for the whole game; stale
+ * results from earlier searches are replaced before current ones.
+ *
+ * The table may be shared by several search threads without locking. Each
+ * word is read and written atomically and the key is stored exclusive-ored
+ * with the data word, so a record torn by two threads writing at once fails
+ * verification and reads as a miss.
+ *
+ *  Created on: 16/10/2026
+ */
+
+#ifndef TTABLE_H_
+#define TTABLE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+class TTable {
+public:
+	// the unpacked contents of a record
+	struct Record {
+		int value;
+		int valueType;
+		int relDepth;
+		int move;
+	};
+
+	explicit TTable(std::size_t mb = DEFAULT_MB) { resize(mb); }
+	void resize(std::size_t mb) { resizeKB(mb << 10); }
+	void resizeKB(std::size_t kb);
+	void clear();
+	void newSearch() { generation = (generation + 1) & 0xFF; }
+	bool probe(std::uint64_t key, Record &rec) const;
+	bool store(std::uint64_t key, int value, int valueType, int relDepth,
+			int move);
+	std::size_t getSizeMB() const { return sizeKB >> 10; }
+
+	enum {NO_VALUE, EXACT, UPPER_BOUND, LOWER_BOUND}; // value types
+	enum { DEFAULT_MB = 16, MAX_DEPTH = 255 };
+
+private:
+	struct Entry {
+		std::atomic<std::uint64_t> key; // key ^ data
+		std::atomic<std::uint64_t> data;
+	};
+
+	/* the first DEPTH_SLOTS records of a bucket are kept for the deepest
+	 * results, the last is always replaced */
+	enum { BUCKET_SIZE = 4, DEPTH_SLOTS = 3, CACHE_LINE = 64 };
+	struct Bucket {
+		Entry entry[BUCKET_SIZE];
+	};
+
+	std::unique_ptr<Bucket[]> storage; // one spare bucket for alignment
+	Bucket *buckets = nullptr;
+	std::size_t count = 0;
+	std::uint64_t mask = 0;
+	std::size_t sizeKB = 0;
+	int generation = 0;
+
+	// a record one search old is worth AGE_WEIGHT less depth when replacing
+	enum { AGE_WEIGHT = 8 };
+
+	/* packing of the data word: value 16 bits, depth, value type, move and
+	 * generation 8 bits each */
+	std::uint64_t pack(int value, int valueType, int relDepth, int move) const;
+	static int depthOf(std::uint64_t data) { return (data >> 16) & 0xFF; }
+	static int typeOf(std::uint64_t data) { return (data >> 24) & 0xFF; }
+	int ageOf(std::uint64_t data) const {
+		return (generation - int(data >> 40)) & 0xFF;
+	}
+};
+
+#endif /* TTABLE_H_ */
@@ -0,0 +1,96 @@
+/*
+ * TimeManager.cpp
+ *
+ *  Created on: 16/10/2026
+ */
+
+#include "TimeManager.h"
+
+#include <algorithm>
+
+// forget the time used in the last game
+void TimeManager::newGame() {
+	used = 0;
+	bank = 0;
+}
+
+// set the target and limit for a move, movesMade moves into the game
+void TimeManager::startMove(int movesMade) {
+	using std::min;
+	using std::max;
+
+	start = clock::now();
+	lastIteration = prevIteration = iterationStart = 0;
+
+	limit = ms(moveTime);
+	baseTarget = ms(moveTime / TARGET_DIVISOR);
+	target = baseTarget + ms(bank / BANK_SHARE);
+
+	if (gameTime > 0) {
+		// share what is left of the game budget over our remaining moves
+		long remaining = max(0L, gameTime - used);
+		long movesLeft = max(long(MIN_MOVES_LEFT),
+				long(EXPECTED_MOVES - movesMade) / 2);
+		baseTarget = ms(remaining / movesLeft);
+		target = baseTarget;
+		limit = min(limit, ms(min(remaining / 2,
+				long(baseTarget.count()) * TARGET_DIVISOR)));
+	}
+
+	target = min(target, limit);
+}
+
+/* the first iteration starts now. Time taken before it, by the book or the
+ * solver, would otherwise count towards it and inflate the branching factor
+ * measured from it. */
+void TimeManager::startSearch() {
+	iterationStart = micros();
+}
+
+/* note the end of an iteration. If the best move changed it is worth looking
+ * deeper, so the target is raised. */
+void TimeManager::iterationDone(bool bestChanged) {
+	long now = micros();
+	prevIteration = lastIteration;
+	lastIteration = now - iterationStart;
+	iterationStart = now;
+
+	if (bestChanged) {
+		target = std::min(limit, std::max(target,
+				baseTarget * int(CRITICAL_FACTOR)));
+	}
+}
+
+/* true if there is time for another iteration: we are within target and the
+ * next iteration, predicted from the last two, should finish within limit */
+bool TimeManager::startIteration() const {
+	using std::chrono::microseconds;
+	long now = micros();
+	if (now >= microseconds(target).count()) return false;
+
+	long branching = DEFAULT_BRANCHING;
+	if (prevIteration > 0) {
+		branching = std::max(long(MIN_BRANCHING), std::min(
+				long(MAX_BRANCHING), lastIteration / prevIteration));
+	}
+	return now + lastIteration * branching < microseconds(limit).count();
+}
+
+// record the time used by this move, banking any time left over
+void TimeManager::endMove() {
+	long now = elapsed();
+	used += now;
+	if (gameTime == 0) {
+		bank = std::max(0L, bank + baseTarget.count() - now);
+		bank = std::min(bank, long(moveTime) * BANK_SHARE);
+	}
+}
+
+long TimeManager::elapsed() const {
+	return std::chrono::duration_cast<ms>(clock::now() - start).count();
+}
+
+long TimeManager::micros() const {
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+			clock::now() - start).count();
+}
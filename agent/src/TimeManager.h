@@ -0,0 +1,74 @@
+/*
+ * TimeManager.h
+ *
+ * Decides how long each move may take. There are two budgets: a limit for
+ * every move (always applied) and optionally a total for the whole game, which
+ * is shared out over the moves we expect to have left. Each move gets a soft
+ * target, after which no new iteration is started, and a hard limit, at which
+ * the search is abandoned. An iteration is only started if, judging by the
+ * branching factor measured over the last two iterations, it can finish
+ * before the hard limit.
+ *
+ * Time not used by a move (a forced move, a proven result) is banked and some
+ * of it is spent on later moves. When the best move changes between
+ * iterations the position is taken to be critical and the target is raised.
+ *
+ *  Created on: 16/10/2026
+ */
+
+#ifndef TIMEMANAGER_H_
+#define TIMEMANAGER_H_
+
+#include <chrono>
+
+class TimeManager {
+public:
+	typedef std::chrono::steady_clock clock;
+
+	void setMoveTime(int ms) { moveTime = ms; }
+	void setGameTime(int ms) { gameTime = ms; }
+	void newGame();
+
+	void startMove(int movesMade);
+	void startSearch();
+	void iterationDone(bool bestChanged);
+	bool startIteration() const;
+	void endMove();
+
+	clock::time_point getDeadline() const { return start + limit; }
+	clock::time_point getTargetTime() const { return start + target; }
+	long elapsed() const; // ms since the start of the move
+
+	enum { DEFAULT_MOVE_TIME = 400 };
+
+private:
+	typedef std::chrono::milliseconds ms;
+
+	int moveTime = DEFAULT_MOVE_TIME; // hard limit for any move
+	int gameTime = 0; // total for the game, 0 if there is none
+
+	long used = 0; // time used so far this game
+	long bank = 0; // time saved on earlier moves
+	clock::time_point start;
+	ms target = ms(0);
+	ms limit = ms(0);
+	ms baseTarget = ms(0);
+
+	// timing of the iterations of this move, in microseconds
+	long lastIteration = 0;
+	long prevIteration = 0;
+	long iterationStart = 0;
+	long micros() const;
+
+	/* experimentally, each level of tree takes 3x longer than sum of all
+	 * previous levels. With only a move limit, the target is a quarter of it
+	 * (so that the next iteration usually fits) plus 1/BANK_SHARE of the
+	 * bank. A critical position may run CRITICAL_FACTOR
+	 * times over target. Games are assumed to last EXPECTED_MOVES moves in
+	 * all, and never fewer than MIN_MOVES_LEFT more of ours. */
+	enum { TARGET_DIVISOR = 4, BANK_SHARE = 4, CRITICAL_FACTOR = 2,
+		EXPECTED_MOVES = 50, MIN_MOVES_LEFT = 8 };
+	enum { MIN_BRANCHING = 2, DEFAULT_BRANCHING = 3, MAX_BRANCHING = 10 };
+};
+
+#endif /* TIMEMANAGER_H_ */
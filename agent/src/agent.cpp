@@ -17,30 +17,54 @@
  *  guaranteed to be at least 32 bits, this is sufficient to represent any
  *  state of a sub-board.
  *
- *  The state of all 9 sub-boards is represented as a vector of 9 sub-boards.
- *  The memory required for this on a typical machine is 9 x 32 bits. If the
- *  subboards were represented by one short int per position, this would be
- *  9 x 9 x 16 bits - four-and-a-half times more memory.
+ *  The state of all 9 sub-boards is represented as an array of 9 sub-boards
+ *  held inline in the state, so a state needs no heap storage. The memory
+ *  required for this on a typical machine is 9 x 32 bits. If the subboards
+ *  were represented by one short int per position, this would be 9 x 9 x 16
+ *  bits - four-and-a-half times more memory.
  *
  *  Given that minimax is a fundamentally depth-first search algorithm, it
  *  might seem wrong to worry about memory usage. However many optimisations
  *  such as transposition tables or deep move ordering require storing states
  *  and can quickly consume large amounts of memory. Therefore I felt it prudent
- *  to begin with a compact representation.
+ *  to begin with a compact representation. The search itself never copies
+ *  states: it works on a single state, making each move and taking it back
+ *  again on the way out.
  *
  *  Speed is important in any adversarial algorithm. One function which will be
  *  called very frequently is the evaluation function which decides the utility
  *  of any state. I have tried to optimise this using bitwise operations with
- *  predetermined comparators.
+ *  predetermined comparators. As a sub-board can only be in one of 3^9 states,
+ *  the evaluation of every sub-board is calculated this way once at startup
+ *  into a table indexed by the 18 bit board, and evaluating a sub-board during
+ *  search is a single table lookup. Similarly the empty positions of a
+ *  sub-board are found as a 9 bit mask and read off into a fixed size list,
+ *  so move generation never uses the heap.
+ *
+ *  The search is written in negamax form, with values always from the point
+ *  of view of the player to move, as a principal variation search: the first
+ *  move at each node is searched with the full window and the rest with a
+ *  null window, and only searched again in full if that shows they may be
+ *  better. Each iteration starts with a narrow (aspiration) window around the
+ *  previous iteration's value and widens it if the value falls outside.
+ *  Within two plies of the cutoff, moves that can't reach alpha by the
+ *  evaluation plus a margin are not searched (futility pruning). Late move
+ *  reductions can be turned on in GameEngine, but lose strength in self-play.
+ *  A table of the squares completing a line on every sub-board lets each
+ *  node take a win in one move without searching, and the search ends at
+ *  a won sub-board or at play sent to a full one, a draw as in game.c.
  *
  *  Move ordering is critical in alpha-beta pruning. The most important move to
  *  order is the first one, and the most value is obtained by ordering the upper
  *  levels of the tree. A transposition table is used to implement move ordering
  *  and also to improve efficiency of minimax. Previously seen states are
  *  recorded along with their calculated value, the value type (exact or a
- *  bound) and the height of the node in the search tree at the time of
- *  evaluation. The table uses std::unordered_set, which is essentially a hash
- *  table. The built-in hash function was specialised for the task.
+ *  bound), the height of the node in the search tree at the time of
+ *  evaluation and the best move found. The table is allocated once at a fixed
+ *  size (set with -m) in cache line sized buckets of four records, so memory
+ *  use does not grow however long the search runs. Within a bucket the deepest
+ *  results are preferred and one record is always replaced. States are keyed
+ *  by a 64 bit Zobrist hash which each move updates with a few XORs.
  *
  *  Another important decision in any minimax algorithm is the heuristic to use.
  *  I used a combination of doublets (rows, columns or diagonals where the
@@ -51,10 +75,57 @@
  *  To perform a valid move within the alloted 2 sec on average, iterative
  *  deepening was used, terminating if the sum of all previous levels took
  *  longer than 1 sec. This was chosen experimentally, with moves averaging
- *  around 2 sec.
+ *  around 2 sec. Time is measured on the wall clock, and the search checks
+ *  the clock every 1024 nodes so that an iteration which would overrun the
+ *  move's hard time limit is abandoned; the best move of the last completed
+ *  iteration is played, or of the abandoned one if it has already searched
+ *  the previous best move.
+ *
+ *  How long a move may take is decided by a time manager. Every move has a
+ *  hard limit (-T), and a total budget for the game can also be given (-G).
+ *  Each move gets a soft target, after which no new iteration is started; an
+ *  iteration is also not started if, judging by the branching factor of the
+ *  last two, it would not finish in time. A move with only one option is
+ *  played at once and the search stops as soon as a win or loss is proven.
+ *  The time saved is banked and spent on later moves, and a position where
+ *  the best move changes between iterations is given extra time.
+ *
+ *  Iterative deepening allowed move ordering using the best moves stored in
+ *  previous iterations. The table is kept for the whole game, so most of
+ *  the tree two moves on is already there when the next search starts. Each
+ *  record carries the generation (search number) that wrote it, and records
+ *  from earlier searches are replaced before current ones.
+ *
+ *  Every record also keeps the best move found from its state, and that move
+ *  is searched first, before the others are generated; if it causes a cutoff
+ *  the node needs no ordering at all. The rest are ordered by the two most
+ *  recent moves to cause a cutoff at each depth (killer moves), then by a
+ *  history score for each square and player, raised whenever that move
+ *  causes a cutoff. Ties are broken by how much each move improves its
+ *  sub-board's evaluation, looked up for all of a node's moves at once (with
+ *  one AVX2 gather where the processor has it), and a move that wins its
+ *  sub-board is always tried first.
+ *
+ *  The second and third moves can be taken from an opening book (-b), made
+ *  beforehand by searching every such position deeply and memory mapped at
+ *  startup; a book move is played at once.
+ *
+ *  When few squares are left empty (-e) the position is first given to an
+ *  exact solver, which searches to the end of the game on a bitboard with
+ *  only win, draw and loss as values; a proven win or draw is played at once.
  *
- *  Iterative deepening allowed move ordering using the stored values of states
- *  from previous iterations. States were not stored between moves.
+ *  The search can use several threads (-t). Helper threads search the same
+ *  position at the same or one greater depth and share the transposition
+ *  table, which is safe to use without locks; the main thread picks the move,
+ *  finding much of its tree already in the table (Lazy SMP).
+ *
+ *  With -l port the agent is a server instead: it accepts connections from
+ *  any number of game servers at once (up to -g) and plays each series with
+ *  an engine of its own. The games share -t worker threads and -m MB of
+ *  tables (transposition tables and the workers' solvers), and each move's
+ *  time runs from its request, however busy the workers are (see Server.h). In either mode messages are read
+ *  from non-blocking sockets, as epoll reports them, into a ring buffer and
+ *  parsed in place (see protocol.h).
  *
  *  I believe this to be a competitive algorithm, typically achieving a search
  *  depth of 8 or 9 at the beginning of a game, and improving as the game
@@ -67,13 +138,30 @@
 #include "SubBoard.h"
 #include "State.h"
 #include "GameEngine.h"
+#include "Server.h"
 
 #include <iostream>
+#include <thread>
 
 // globals for game state information
 static GameEngine ge;
+static bool ponder = false; // search during the opponent's turn
+static const char *bookPath = nullptr; // opening book, opened by openBook
+static std::shared_ptr<const Book> book;
 enum { START_DEPTH = 5 };
 
+/* engine options from the command line, applied to ge or, in server mode,
+ * to the engine of each game. In server mode -m is the budget for all the
+ * games together and -t the number of worker threads they share. */
+static int hashMB = TTable::DEFAULT_MB;
+static int threads = 0; // 0 for one (one per core in server mode)
+static int moveTime = TimeManager::DEFAULT_MOVE_TIME;
+static int gameTime = 0;
+static int solverEmpty = GameEngine::DEFAULT_SOLVER_EMPTY;
+static int statsFd = -1;
+static int listenPort = 0; // server mode if not 0
+static int maxGames = Server::DEFAULT_GAMES;
+
 /*********************************************************//*
    Print usage information and exit
 */
@@ -83,9 +171,57 @@ void usage( char argv0[] ) {
 	cout << "Usage: " << argv0 << "\n";
 	cout << "       [-p port]" << endl;
 	cout << "       [-h host]" << endl;
+	cout << "       [-m hash size in MB]" << endl;
+	cout << "       [-t search threads]" << endl;
+	cout << "       [-P (ponder)]" << endl;
+	cout << "       [-T time limit per move in ms]" << endl;
+	cout << "       [-G time for the whole game in ms]" << endl;
+	cout << "       [-e empty squares to start solving, 0 for never]" << endl;
+	cout << "       [-b opening book file]" << endl;
+	cout << "       [-j file descriptor for per-move JSON statistics]" << endl;
+	cout << "       [-l port to serve games on (server mode)]" << endl;
+	cout << "       [-g most games at once in server mode]" << endl;
 	std::exit(EXIT_FAILURE);
 }
 
+/*********************************************************//*
+   Search for our move, then ponder on the opponent's reply if enabled
+*/
+static int chooseMove() {
+	int move = ge.iterDeepSearch(START_DEPTH);
+	if (ponder) {
+		ge.startPonder(START_DEPTH);
+	}
+	return move;
+}
+
+/*********************************************************//*
+   Open the opening book, if there is one, once
+*/
+static void openBook() {
+	if (bookPath == nullptr || book) return;
+
+	std::shared_ptr<Book> b = std::make_shared<Book>();
+	if (b->open(bookPath)) {
+		book = b;
+	}
+	else {
+		std::cerr << "could not open opening book " << bookPath << std::endl;
+		bookPath = nullptr;
+	}
+}
+
+/*********************************************************//*
+   Apply the command-line options (but the hash size and threads) to an engine
+*/
+static void configure(GameEngine &e) {
+	e.setMoveTime(moveTime);
+	e.setGameTime(gameTime);
+	e.setSolverEmpty(solverEmpty);
+	e.setStatsFd(statsFd);
+	e.setBook(book);
+}
+
 /*********************************************************//*
    Parse command-line arguments
 */
@@ -107,16 +243,118 @@ void agent_parse_args( int argc, char *argv[] )
 			host = argv[i+1];
 			i += 2;
 		}
+		else if (std::string("-m").compare(argv[i]) == 0) {
+			if (i + 1 >= argc) {
+				usage(argv[0]);
+			}
+			hashMB = std::strtol(argv[i+1], nullptr, 0);
+			i += 2;
+		}
+		else if (std::string("-t").compare(argv[i]) == 0) {
+			if (i + 1 >= argc) {
+				usage(argv[0]);
+			}
+			threads = std::strtol(argv[i+1], nullptr, 0);
+			i += 2;
+		}
+		else if (std::string("-T").compare(argv[i]) == 0) {
+			if (i + 1 >= argc) {
+				usage(argv[0]);
+			}
+			moveTime = std::strtol(argv[i+1], nullptr, 0);
+			i += 2;
+		}
+		else if (std::string("-G").compare(argv[i]) == 0) {
+			if (i + 1 >= argc) {
+				usage(argv[0]);
+			}
+			gameTime = std::strtol(argv[i+1], nullptr, 0);
+			i += 2;
+		}
+		else if (std::string("-e").compare(argv[i]) == 0) {
+			if (i + 1 >= argc) {
+				usage(argv[0]);
+			}
+			solverEmpty = std::strtol(argv[i+1], nullptr, 0);
+			i += 2;
+		}
+		else if (std::string("-b").compare(argv[i]) == 0) {
+			if (i + 1 >= argc) {
+				usage(argv[0]);
+			}
+			bookPath = argv[i+1];
+			i += 2;
+		}
+		else if (std::string("-j").compare(argv[i]) == 0) {
+			if (i + 1 >= argc) {
+				usage(argv[0]);
+			}
+			statsFd = std::strtol(argv[i+1], nullptr, 0);
+			i += 2;
+		}
+		else if (std::string("-l").compare(argv[i]) == 0) {
+			if (i + 1 >= argc) {
+				usage(argv[0]);
+			}
+			listenPort = std::strtol(argv[i+1], nullptr, 0);
+			i += 2;
+		}
+		else if (std::string("-g").compare(argv[i]) == 0) {
+			if (i + 1 >= argc) {
+				usage(argv[0]);
+			}
+			maxGames = std::strtol(argv[i+1], nullptr, 0);
+			i += 2;
+		}
+		else if (std::string("-P").compare(argv[i]) == 0) {
+			ponder = true;
+			i += 1;
+		}
 		else {
 			usage(argv[0]);
 		}
 	}
+
+	if (listenPort != 0) {
+		// ge is not used, give back its table
+		ge.setHashSize(0);
+	}
+	else {
+		ge.setHashSize(hashMB);
+		ge.setThreads(threads);
+		configure(ge);
+	}
+}
+
+/*********************************************************//*
+   True if the arguments asked for server mode
+*/
+int agent_server_mode() {
+	return listenPort != 0;
+}
+
+/*********************************************************//*
+   Serve games on every connection to listenPort, see Server.h
+*/
+int agent_serve() {
+	openBook();
+	int workers = threads > 0 ? threads
+			: std::max(1u, std::thread::hardware_concurrency());
+	Server server(maxGames, workers, hashMB, moveTime, START_DEPTH, configure);
+	if (!server.listen(listenPort)) {
+		return EXIT_FAILURE;
+	}
+	server.run();
+	return EXIT_FAILURE;
 }
 
 /*********************************************************//*
    Called at the beginning of a series of games
 */
-void agent_init() { }
+void agent_init() {
+	openBook();
+	ge.setBook(book);
+}
 
 /*********************************************************//*
    Called at the beginning of each game
@@ -140,7 +378,7 @@ int agent_second_move( int board_num, int prev_move ) {
 	ge.setCurrSub(prev_move);
 
 	// make a move
-	return ge.iterDeepSearch(START_DEPTH);
+	return chooseMove();
 }
 
 /*********************************************************//*
@@ -157,7 +395,7 @@ int agent_third_move( int board_num, int first_move, int prev_move ) {
 	ge.setCurrSub(prev_move);
 
 	// make a move
-	return ge.iterDeepSearch(START_DEPTH);
+	return chooseMove();
 }
 
 /*********************************************************//*
@@ -173,13 +411,14 @@ int agent_next_move( int prev_move ) {
 	ge.setCurrSub(prev_move);
 
 	// make an alpha-beta search
-	return ge.iterDeepSearch(START_DEPTH);
+	return chooseMove();
 }
 
 /*********************************************************//*
    Receive last move and mark it on the board
 */
 void agent_last_move( int prev_move ) {
+	ge.stopPonder();
 	ge.update(ge.getMove(), prev_move, ge.getOpponent());
 }
 
@@ -190,12 +429,12 @@ void agent_gameover(
                     int result,// WIN, LOSS or DRAW
                     int cause  // TRIPLE, ILLEGAL_MOVE, TIMEOUT or FULL_BOARD
                    ) {
-  // nothing to do here
+  ge.stopPonder();
 }
 
 /*********************************************************//*
    Called after the series of games
 */
 void agent_cleanup() {
-  // nothing to do here
+  ge.stopPonder();
 }
@@ -18,6 +18,12 @@ extern "C" {
  //  parse command-line arguments
 void agent_parse_args( int argc, char *argv[] );
 
+ //  non-zero if the arguments asked for server mode (-l)
+int  agent_server_mode();
+
+ //  serve games on many connections at once instead, returns the exit status
+int  agent_serve();
+
  //  called at the beginning of a series of games
 void agent_init();
 
@@ -9,24 +9,25 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
 #include <arpa/inet.h> 
 #include <netinet/tcp.h>
 #include <netdb.h>
+#include <fcntl.h>
 #include <unistd.h>
 
 #include "common.h"
 #include "agent.h"
+#include "protocol.h"
 
 int   port=31415;
 char *local="localhost";
 char *host;
 
 int pipe_fd;
+int epoll_fd;
 
-FILE* pipe_in_stream;
-FILE* pipe_out_stream;
-
-char client_buf[256];
+proto_ring client_ring; // received from the server, not yet parsed
 
 /*********************************************************//*
    Close the network connection
@@ -34,23 +35,39 @@ char client_buf[256];
 void client_cleanup()
 {
   agent_cleanup();
-  fclose(pipe_in_stream);
-  fclose(pipe_out_stream);
+  close(epoll_fd);
   close(pipe_fd);
   exit(0);// must exit immediately, to avoid "zombie" process
 }
 
 /*********************************************************//*
-   Read from pipe input stream to buffer
+   Parse the next message from the server into msg, waiting
+   for the socket to have more if need be
 */
-void pipe_read(char *buf)
+void pipe_read( proto_msg *msg )
 {
-  fflush(pipe_in_stream);
+  struct epoll_event ev;
+  int parsed;
 
-  buf[0] = '\0';
-  fscanf(pipe_in_stream, "%s", buf);
+  while( (parsed = proto_next( &client_ring,msg )) == 0 ) {
+    if( epoll_wait( epoll_fd,&ev,1,-1 ) < 0 ) {
+      continue; // interrupted
+    }
+    if( !proto_receive( pipe_fd,&client_ring )) {
+      client_cleanup();
+    }
+  }
+  if( parsed < 0 ) {
+    client_cleanup();
+  }
+}
 
-  if( buf[0] == '\0' ) {
+/*********************************************************//*
+   Send a move to the server
+*/
+void client_send_move( int this_move )
+{
+  if( !proto_send_move( pipe_fd,this_move )) {
     client_cleanup();
   }
 }
@@ -60,10 +77,7 @@ void pipe_read(char *buf)
 */
 void client_second_move( int board_num, int prev_move )
 {
-  int this_move;
-  this_move = agent_second_move( board_num,prev_move );
-  fprintf(pipe_out_stream, "%d\n",this_move);
-  fflush(pipe_out_stream);
+  client_send_move( agent_second_move( board_num,prev_move ));
 }
 
 /*********************************************************//*
@@ -75,10 +89,7 @@ void client_third_move(
                        int prev_move
                       )
 {
-  int this_move;
-  this_move=agent_third_move(board_num,first_move,prev_move);
-  fprintf(pipe_out_stream, "%d\n",this_move);
-  fflush(pipe_out_stream);
+  client_send_move( agent_third_move( board_num,first_move,prev_move ));
 }
 
 /*********************************************************//*
@@ -86,10 +97,7 @@ void client_third_move(
 */
 void client_next_move( int prev_move )
 {
-  int this_move;
-  this_move = agent_next_move( prev_move );
-  fprintf(pipe_out_stream,"%d\n",this_move);
-  fflush(pipe_out_stream);
+  client_send_move( agent_next_move( prev_move ));
 }
 
 /*********************************************************//*
@@ -134,96 +142,69 @@ int tcpopen()
   return sd;
 }
 
-/*********************************************************//*
-   Determine cause for win, loss or draw
-*/
-int get_cause( char *buf )
-{
-  int cause=TRIPLE;
-  if( strcmp(client_buf,"triple).") == 0) {
-    cause = TRIPLE;
-  }
-  else if( strcmp(client_buf,"timeout).") == 0) {
-    cause = TIMEOUT;
-  }
-  else if( strcmp(client_buf,"illegal_move).") == 0) {
-    cause = ILLEGAL_MOVE;
-  }
-  else if( strcmp(client_buf,"full_board).") == 0) {
-    cause = FULL_BOARD;
-  }
-  return( cause );
-}
-
 /*********************************************************/
 int main(int argc, char** argv)
 {
-  int player=0;
-  int result=DRAW;  // WIN, LOSS or DRAW
-  int cause =TRIPLE;// TRIPLE, TIMEOUT, ILLEGAL_MOVE or FULL_BOARD
-  int board_num,first_move,prev_move;
+  proto_msg msg;
   int sd;
-  char ch;
+  struct epoll_event ev;
 
   host = local; // default
   agent_parse_args( argc, argv );
+  if( agent_server_mode() ) {
+    return agent_serve();
+  }
 
   sd = tcpopen(); // host,port );
 
+  // non-blocking, read only when epoll says there is something
   pipe_fd = sd;
-  pipe_in_stream  = fdopen(sd,"r");
-  pipe_out_stream = fdopen(sd,"w");
+  fcntl( sd,F_SETFL,fcntl( sd,F_GETFL,0 ) | O_NONBLOCK );
+  epoll_fd = epoll_create1( 0 );
+  if( epoll_fd < 0 ) {
+    perror("cannot create epoll instance ");
+    exit(1);
+  }
+  ev.events  = EPOLLIN;
+  ev.data.fd = sd;
+  epoll_ctl( epoll_fd,EPOLL_CTL_ADD,sd,&ev );
+  proto_ring_init( &client_ring );
 
-  client_buf[0] = '\0';
-  pipe_read(client_buf);
+  while( TRUE ) {
+    pipe_read( &msg );
 
-  while( TRUE ) {    
-    if(strcmp(client_buf,"init.") == 0) {
+    switch( msg.type ) {
+    case PROTO_INIT:
       agent_init();
-    }
-    else if(sscanf(client_buf,"start(%c).",&ch) == 1) {
-      player = ( ch == 'x' ) ? 0 : 1 ;
-      agent_start( player );
-    }
-    else if(sscanf(client_buf,"second_move(%d,%d).",
-                   &board_num,&prev_move) == 2 ) {
-      client_second_move( board_num,prev_move );
-    }
-    else if(sscanf(client_buf,"third_move(%d,%d,%d).",
-                   &board_num,&first_move,&prev_move) == 3) {
-      client_third_move( board_num,first_move,prev_move );
-    }
-    else if(sscanf(client_buf,"next_move(%d).",&prev_move)==1){
-      client_next_move( prev_move );
-    }
-    else if(sscanf(client_buf,"last_move(%d).",&prev_move)==1){
-      agent_last_move( prev_move );
-    }
-    else if(   strcmp(client_buf,"win(") > 0
-            && strcmp(client_buf,"win)") < 0 ) {
-      result = WIN;
-      cause = get_cause(client_buf+4);
-      agent_gameover(result,cause);
-    }
-    else if(   strcmp(client_buf,"loss(") > 0
-            && strcmp(client_buf,"loss)") < 0 ) {
-      result = LOSS;
-      cause = get_cause(client_buf+5);
-      agent_gameover(result,cause);
-    }
-    else if(   strcmp(client_buf,"draw(") > 0
-            && strcmp(client_buf,"draw)") < 0 ) {
-      result = DRAW;
-      cause = get_cause(client_buf+5);
-      agent_gameover(result,cause);
-    }
-    else if(strcmp(client_buf,"end") == 0) {
+      break;
+    case PROTO_START:
+      agent_start( msg.player );
+      break;
+    case PROTO_SECOND_MOVE:
+      client_second_move( msg.args[0],msg.args[1] );
+      break;
+    case PROTO_THIRD_MOVE:
+      client_third_move( msg.args[0],msg.args[1],msg.args[2] );
+      break;
+    case PROTO_NEXT_MOVE:
+      client_next_move( msg.args[0] );
+      break;
+    case PROTO_LAST_MOVE:
+      agent_last_move( msg.args[0] );
+      break;
+    case PROTO_WIN:
+      agent_gameover( WIN,msg.cause );
+      break;
+    case PROTO_LOSS:
+      agent_gameover( LOSS,msg.cause );
+      break;
+    case PROTO_DRAW:
+      agent_gameover( DRAW,msg.cause );
+      break;
+    case PROTO_END:
       client_cleanup();
       return 0;
-    }        
-
-    client_buf[0] = '\0';
-    pipe_read(client_buf);
+    }
   }
 
   return 0;
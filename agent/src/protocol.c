@@ -0,0 +1,201 @@
+/*
+ * protocol.c
+ *
+ *  Created on: 16/10/2026
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+#include "common.h"
+#include "protocol.h"
+
+#define RING_MASK (PROTO_RING_SIZE - 1)
+
+ //  how long proto_send_move waits for room to send, in ms
+enum { SEND_WAIT = 1000 };
+
+ //  every message, '%d' standing for a number, '%c' for x or o and '%w' for
+ //  the cause of a result
+static const struct {
+	int type;
+	const char *pattern;
+} patterns[] = {
+	{ PROTO_NEXT_MOVE, "next_move(%d)." },
+	{ PROTO_LAST_MOVE, "last_move(%d)." },
+	{ PROTO_SECOND_MOVE, "second_move(%d,%d)." },
+	{ PROTO_THIRD_MOVE, "third_move(%d,%d,%d)." },
+	{ PROTO_START, "start(%c)." },
+	{ PROTO_INIT, "init." },
+	{ PROTO_WIN, "win(%w)." },
+	{ PROTO_LOSS, "loss(%w)." },
+	{ PROTO_DRAW, "draw(%w)." },
+	{ PROTO_END, "end" },
+};
+
+static const struct {
+	int cause;
+	const char *word;
+} causes[] = {
+	{ TRIPLE, "triple" },
+	{ TIMEOUT, "timeout" },
+	{ ILLEGAL_MOVE, "illegal_move" },
+	{ FULL_BOARD, "full_board" },
+};
+
+static int is_space( char c ) {
+	return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+/*********************************************************//*
+   Empty the ring
+*/
+void proto_ring_init( proto_ring *r ) {
+	r->head = 0;
+	r->tail = 0;
+}
+
+/*********************************************************//*
+   The free bytes after head, up to the end of the ring
+*/
+char *proto_ring_space( proto_ring *r, int *len ) {
+	unsigned start = r->head & RING_MASK;
+	unsigned room = PROTO_RING_SIZE - (r->head - r->tail);
+	*len = (int)(room < PROTO_RING_SIZE - start ? room : PROTO_RING_SIZE - start);
+	return r->data + start;
+}
+
+void proto_ring_produced( proto_ring *r, int n ) {
+	r->head += n;
+}
+
+/*********************************************************//*
+   Match the message from pos to end against a pattern, filling in m
+*/
+static int match( const proto_ring *r, unsigned pos, unsigned end,
+                  const char *pattern, proto_msg *m ) {
+	int arg = 0;
+	unsigned i;
+	for ( ; *pattern != '\0'; ++pattern) {
+		if (*pattern != '%') {
+			if (pos == end || r->data[pos++ & RING_MASK] != *pattern) return 0;
+			continue;
+		}
+		++pattern;
+		if (*pattern == 'd') {
+			int n = 0, digits = 0;
+			while (pos != end && r->data[pos & RING_MASK] >= '0' &&
+					r->data[pos & RING_MASK] <= '9' && digits < 9) {
+				n = n * 10 + (r->data[pos++ & RING_MASK] - '0');
+				++digits;
+			}
+			if (digits == 0) return 0;
+			m->args[arg++] = n;
+		}
+		else if (*pattern == 'c') {
+			if (pos == end) return 0;
+			m->player = (r->data[pos++ & RING_MASK] == 'x') ? 0 : 1;
+		}
+		else if (*pattern == 'w') {
+			// a word of letters and '_', TRIPLE if it isn't a cause we know
+			unsigned word = pos;
+			while (pos != end && (r->data[pos & RING_MASK] == '_' ||
+					(r->data[pos & RING_MASK] >= 'a' &&
+					r->data[pos & RING_MASK] <= 'z'))) {
+				++pos;
+			}
+			m->cause = TRIPLE;
+			for (i = 0; i != sizeof(causes) / sizeof(causes[0]); ++i) {
+				const char *w = causes[i].word;
+				unsigned p = word;
+				while (*w != '\0' && p != pos && r->data[p & RING_MASK] == *w) {
+					++w;
+					++p;
+				}
+				if (*w == '\0' && p == pos) m->cause = causes[i].cause;
+			}
+		}
+	}
+	return pos == end;
+}
+
+/*********************************************************//*
+   Parse the next message where it lies in the ring
+*/
+int proto_next( proto_ring *r, proto_msg *m ) {
+	unsigned end, i;
+
+	while (r->tail != r->head && is_space(r->data[r->tail & RING_MASK])) {
+		++r->tail;
+	}
+	for (end = r->tail; end != r->head; ++end) {
+		if (is_space(r->data[end & RING_MASK])) break;
+	}
+	if (end - r->tail > PROTO_MAX_MESSAGE) return -1;
+	if (end == r->head) return 0;
+
+	m->type = PROTO_UNKNOWN;
+	for (i = 0; i != sizeof(patterns) / sizeof(patterns[0]); ++i) {
+		if (match(r, r->tail, end, patterns[i].pattern, m)) {
+			m->type = patterns[i].type;
+			break;
+		}
+	}
+	r->tail = end;
+	return 1;
+}
+
+/*********************************************************//*
+   Receive once from a non-blocking socket into the ring
+*/
+int proto_receive( int fd, proto_ring *r ) {
+	int len;
+	char *space = proto_ring_space(r, &len);
+	ssize_t n;
+	if (len == 0) return 0;
+
+	n = recv(fd, space, len, 0);
+	if (n > 0) {
+		proto_ring_produced(r, n);
+		return 1;
+	}
+	if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+		return 1;
+	}
+	return 0;
+}
+
+/*********************************************************//*
+   Send a move and a newline
+*/
+int proto_send_move( int fd, int move ) {
+	char buf[16];
+	int len = 0, sent = 0;
+	char digits[12];
+	int d = 0;
+	unsigned n = move < 0 ? 0 : move;
+	do {
+		digits[d++] = '0' + n % 10;
+		n /= 10;
+	} while (n != 0);
+	while (d != 0) buf[len++] = digits[--d];
+	buf[len++] = '\n';
+
+	while (sent < len) {
+		ssize_t k = send(fd, buf + sent, len - sent, MSG_NOSIGNAL);
+		if (k > 0) {
+			sent += k;
+		}
+		else if (k < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			struct pollfd p;
+			p.fd = fd;
+			p.events = POLLOUT;
+			if (poll(&p, 1, SEND_WAIT) <= 0) return 0;
+		}
+		else if (!(k < 0 && errno == EINTR)) {
+			return 0;
+		}
+	}
+	return 1;
+}
@@ -0,0 +1,69 @@
+/*
+ * protocol.h
+ *
+ * Parsing of the game server's messages, and writing of our replies, on
+ * non-blocking sockets. Bytes are received straight into a ring buffer
+ * (proto_ring_space, proto_ring_produced) and each message is parsed where it
+ * lies (proto_next), with no copying and no stdio: a message is a run of
+ * non-space characters ended by a space or newline, as client.c used to read
+ * them with fscanf.
+ *
+ *  Created on: 16/10/2026
+ */
+
+#ifndef PROTOCOL_H_
+#define PROTOCOL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+ //  message types
+enum {
+	PROTO_UNKNOWN, PROTO_INIT, PROTO_START, PROTO_SECOND_MOVE,
+	PROTO_THIRD_MOVE, PROTO_NEXT_MOVE, PROTO_LAST_MOVE, PROTO_WIN,
+	PROTO_LOSS, PROTO_DRAW, PROTO_END
+};
+
+ //  ring size, a power of 2, and the longest message allowed
+enum { PROTO_RING_SIZE = 4096, PROTO_MAX_MESSAGE = 64 };
+
+typedef struct {
+	int type;
+	int args[3]; // sub-board and move numbers, in the order sent
+	int player; // start: 0 for x, 1 for o
+	int cause; // win, loss, draw: TRIPLE, TIMEOUT ... as in common.h
+} proto_msg;
+
+ //  received bytes from tail up to head, both counting from the start
+typedef struct {
+	char data[PROTO_RING_SIZE];
+	unsigned head;
+	unsigned tail;
+} proto_ring;
+
+void proto_ring_init( proto_ring *r );
+
+ //  where to receive into next, and how many bytes fit there
+char *proto_ring_space( proto_ring *r, int *len );
+
+ //  n bytes have been received into proto_ring_space
+void proto_ring_produced( proto_ring *r, int n );
+
+ //  parse the next message into m, 1 if there was a whole one, 0 if more
+ //  bytes are needed, -1 if the sender is sending nonsense
+int  proto_next( proto_ring *r, proto_msg *m );
+
+ //  receive what there is on a non-blocking socket, 1 if anything came (or
+ //  nothing yet), 0 at end of file or on an error or a full ring
+int  proto_receive( int fd, proto_ring *r );
+
+ //  send a move on a non-blocking socket, waiting for room if need be,
+ //  0 on failure
+int  proto_send_move( int fd, int move );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PROTOCOL_H_ */